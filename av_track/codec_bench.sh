@@ -0,0 +1,66 @@
+#!/bin/bash
+# 对比各视频编码器（h264/h265/vp8/vp9/av1）在同一输入上的 CPU 占用和实际码率
+# 用法：./codec_bench.sh [秒数] [编码器...]，运行期间需要有一个观看端连接，否则采集不会开始
+# 码率未由控制端下发时各编码器使用默认质量模式，结果反映相同画面下的 CPU/码率取舍
+TARGET_HOST="fy403.cn" # 信令服务器地址
+TARGET_PORT=8000 # 信令服务器端口
+VIDEO_DEVICE="/dev/video1" # 摄像头设备
+CLIENT_ID="bench_cam" # 客户端ID
+RESOLUTION="640x480" # 画面分辨率
+INPUT_FORMAT="mjpeg" # mjpeg, yuyv422
+FPS=30 # 画面帧率
+DURATION=${1:-60} # 每个编码器运行时长（秒）
+shift
+CODECS=${@:-h264 h265 vp8 vp9 av1}
+STATS_INTERVAL=10 # 统计输出间隔（秒），码率按该间隔计算
+BUILD_DIR="./build"
+
+# 读取进程累计的 CPU 时间（jiffies），包含已退出线程的用量
+sample_cpu() {
+    local stat=($(cut -d')' -f2 /proc/$1/stat))
+    echo $((stat[11] + stat[12]))
+}
+
+run_codec() {
+    local codec=$1
+    local log="codec_bench_${codec}.log"
+
+    echo "$(date): Running $codec for ${DURATION}s..."
+    $BUILD_DIR/webrtc_publisher \
+    -w $TARGET_HOST -x $TARGET_PORT \
+    -R $RESOLUTION -F $FPS \
+    -V $INPUT_FORMAT \
+    -E $codec \
+    -q $STATS_INTERVAL \
+    -c $CLIENT_ID -i $VIDEO_DEVICE > $log 2>&1 &
+    local pid=$!
+
+    # 等待启动和观看端连接后再开始计时
+    sleep 5
+    if ! kill -0 $pid 2>/dev/null; then
+        echo "$codec: publisher exited, see $log"
+        return
+    fi
+    local skip=$(grep -c "\[Video\] encode:" $log)
+    local before=$(sample_cpu $pid)
+    sleep $DURATION
+    local after=$(sample_cpu $pid)
+
+    kill -INT $pid
+    wait $pid
+
+    local hz=$(getconf CLK_TCK)
+    local cpu=$(awk -v j=$((after - before)) -v hz=$hz -v d=$DURATION \
+        'BEGIN { printf "%.1f", j * 100.0 / hz / d }')
+    # 只统计计时窗口内输出的编码统计
+    local encode=$(grep "\[Video\] encode:" $log | tail -n +$((skip + 1)) | awk '
+        { for (i = 1; i <= NF; i++) { split($i, kv, "="); gsub(",", "", kv[2]); v[kv[1]] = kv[2] }
+          if (v["frames"] > 0) { frames += v["frames"]; us += v["avg_us"] * v["frames"]; kbps += v["kbps"]; n++ } }
+        END { if (n) printf "frames=%d avg_encode_us=%d kbps=%d", frames, us / frames, kbps / n;
+              else printf "no encoded frames" }')
+    echo "$codec: cpu=${cpu}% $encode"
+}
+
+for codec in $CODECS; do
+    run_codec $codec
+done
@@ -4,6 +4,7 @@
 #include "capture.h"
 #include <memory>
 #include <string>
+#include <vector>
 
 // Forward declarations
 class Encoder;
@@ -42,15 +43,23 @@ public:
 
 private:
   void capture_loop() override;
-  void decode_loop() override;
-  void encode_loop() override;
-  void send_loop() override;
+  bool decode_step() override;
+  bool encode_step() override;
+  bool send_step() override;
+  // 编码一帧并推入发送队列，编码任务和 fused 模式共用
+  void encode_and_queue(TimedFrame input);
 
   AudioDeviceParams audio_params_;
   AVFormatContext *format_context_ = nullptr;
   AVCodecContext *codec_context_ = nullptr;
   int audio_stream_index_ = -1;
 
+  // 各阶段任务在多次执行之间保留的状态，同一阶段的任务不会并发执行
+  AVFramePtr decoded_frame_;
+  AVPacketPtr encode_packet_;
+  std::vector<TimedFrame> decoded_batch_;
+  std::vector<TimedPacket> send_batch_;
+
   std::shared_ptr<rtc::Track> track_;
 };
 
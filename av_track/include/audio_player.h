@@ -2,13 +2,14 @@
 #define AUDIO_PLAYER_H
 
 #include "audio_capturer.h"
+#include "av_ptr.h"
+#include "executor.h"
 #include "opus_decoder.h"
 #include "rtc/rtc.hpp"
 #include "safe_queue.h"
 #include <atomic>
 #include <mutex>
 #include <string>
-#include <thread>
 #include <vector>
 
 extern "C" {
@@ -43,7 +44,9 @@ public:
   float getVolume() const;      // 获取当前音量
 
 private:
-  void decodeThread();
+  // 每次解码一批数据包，返回 true 表示队列中还有剩余
+  bool decodeStep();
+  void decodePacket(AVPacketPtr packet);
   bool initSDLAudio(int sample_rate, int channels, SDL_AudioFormat format,
                     Uint16 frame_size);
   void cleanup();
@@ -54,8 +57,17 @@ private:
   AudioPlayerDeviceParams params_;
   std::atomic<bool> running_{false};
 
-  std::thread decode_thread_;
-  SafeQueue<AVPacket *> decode_queue_;
+  static constexpr size_t kDecodeBatchSize = 8;
+  std::unique_ptr<SerialTask> decode_task_;
+  SafeQueue<AVPacketPtr> decode_queue_;
+
+  // 解码任务在多次执行之间保留的状态
+  AVFramePtr decoded_frame_;
+  AVFramePtr resampled_frame_;
+  bool decoder_initialized_ = false;
+  bool sdl_initialized_ = false;
+  bool sdl_failed_ = false; // SDL 音频设备打开失败后停止播放，只报告一次
+  bool resampler_initialized_ = false;
 
   // Opus 解码器
   std::unique_ptr<OpusDecoder> opus_decoder_;
@@ -67,7 +79,7 @@ private:
   // 添加重采样相关成员
   SwrContext *swr_ctx_ = nullptr;
   // 音频样本队列
-  SafeQueue<AVFrame *> audio_sample_queue_;
+  SafeQueue<AVFramePtr> audio_sample_queue_;
 
   // 性能统计
   std::atomic<int> packets_received_{0};
@@ -0,0 +1,34 @@
+#ifndef AV1_ENCODER_H
+#define AV1_ENCODER_H
+
+#include "encoder.h"
+#include <atomic>
+#include <utility>
+
+// AV1 实时编码，优先使用 libaom（realtime usage），没有时使用 SVT-AV1
+class Av1Encoder : public Encoder {
+public:
+  Av1Encoder(bool debug_enabled = false);
+  ~Av1Encoder();
+
+  bool open_encoder(int width, int height, int fps, int64_t bit_rate) override;
+  void close_encoder() override;
+
+  AVCodecContext *get_context() const override { return encoder_context_; }
+
+  bool encode_frame(AVFrame *frame, AVPacket *packet) override;
+  void request_keyframe() override { keyframe_requested_ = true; }
+
+protected:
+  AVCodecContext *exchange_context(AVCodecContext *context) override {
+    std::swap(context, encoder_context_);
+    return context;
+  }
+
+private:
+  bool debug_enabled_;
+  AVCodecContext *encoder_context_;
+  const AVCodec *codec_;
+  std::atomic<bool> keyframe_requested_{false};
+};
+#endif // AV1_ENCODER_H
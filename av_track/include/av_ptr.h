@@ -0,0 +1,50 @@
+#ifndef AV_PTR_H
+#define AV_PTR_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+}
+
+// FFmpeg 对象的 RAII 句柄：无状态 deleter，sizeof 与裸指针相同，
+// 在队列和各处理阶段之间只移动所有权，不再 av_packet_ref 拷贝
+struct AVPacketDeleter {
+  void operator()(AVPacket *packet) const { av_packet_free(&packet); }
+};
+
+struct AVFrameDeleter {
+  void operator()(AVFrame *frame) const { av_frame_free(&frame); }
+};
+
+using AVPacketPtr = std::unique_ptr<AVPacket, AVPacketDeleter>;
+using AVFramePtr = std::unique_ptr<AVFrame, AVFrameDeleter>;
+
+// 分配失败时返回空句柄
+inline AVPacketPtr make_av_packet() { return AVPacketPtr(av_packet_alloc()); }
+inline AVFramePtr make_av_frame() { return AVFramePtr(av_frame_alloc()); }
+
+// 单调时钟的当前时间（微秒），用于计算数据在流水线中的滞留时间
+inline int64_t steady_now_us() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// 携带采集时刻的包/帧，各处理阶段据此丢弃超过截止时间的数据
+struct TimedPacket {
+  AVPacketPtr packet;
+  int64_t capture_us = 0;
+};
+
+struct TimedFrame {
+  AVFramePtr frame;
+  int64_t capture_us = 0;
+  // 视频输出链路的版本号，重建输出链路时编码阶段据此在帧边界切换编码器
+  uint32_t generation = 0;
+};
+
+#endif // AV_PTR_H
@@ -1,10 +1,14 @@
 #ifndef CAPTURE_H
 #define CAPTURE_H
 
+#include "av_ptr.h"
+#include "executor.h"
 #include "safe_queue.h"
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <functional>
+#include <initializer_list>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -25,6 +29,12 @@ namespace rtc {
 class Track;
 }
 
+// 流水线中可以按截止时间丢弃数据的阶段
+enum class PipelineStage { Decode = 0, Encode, Send };
+constexpr size_t kPipelineStageCount = 3;
+// 每个阶段任务单次最多处理的数据个数，处理完后让出工作线程
+constexpr size_t kStageBatchSize = 8;
+
 class Capture {
 public:
   Capture(bool debug_enabled = false, size_t decode_queue_capacity = 512,
@@ -43,21 +53,46 @@ public:
   void remove_track_callback(const std::string &id);
   bool has_track_callbacks() const;
 
+  // 每隔 seconds 秒输出一次各队列的统计并开始新的统计周期，0 表示关闭；
+  // 需在 start() 之前调用
+  void set_queue_stats_interval(int seconds);
+
+  // 各阶段的时延预算（毫秒）：数据从采集到该阶段取出时已超过预算则直接丢弃，
+  // 不再做解码/编码/发送等工作；0 表示不限制
+  void set_stage_budget_ms(PipelineStage stage, int budget_ms);
+  uint64_t stale_drops(PipelineStage stage) const;
+
+  // fused 模式：解码→缩放→编码在同一个任务内完成，不再经过 encode_queue_，
+  // 只保留采集和发送两端的异步队列；适合双核等低配设备。需在 start() 之前调用
+  void set_fused_pipeline(bool fused) { fused_pipeline_ = fused; }
+
 protected:
+  // 采集是阻塞的设备读取，仍然运行在独立线程上
   virtual void capture_loop() = 0;
-  virtual void decode_loop() {}
-  virtual void encode_loop() = 0;
-  virtual void send_loop() = 0;
-  void bind_thread_to_cpu(std::thread& thread, int cpu_id);
-  int get_cpu_count();
+  // 其余阶段作为串行任务运行在共享线程池上：每次从输入队列取出一批数据处理，
+  // 返回 true 表示队列中还有剩余
+  virtual bool decode_step() { return false; }
+  virtual bool encode_step() = 0;
+  virtual bool send_step() = 0;
+  // 为需要的阶段创建任务，由子类在 start() 中调用
+  void start_stages(TaskPriority priority,
+                    std::initializer_list<PipelineStage> stages);
+  // 数据入队后唤醒消费该队列的阶段
+  void wake_stage(PipelineStage stage);
+  // 由子类在 start() 中启动队列统计线程
+  void start_queue_stats(const std::string &label);
+  virtual void log_queue_stats(const std::string &label);
+  // 超过该阶段时延预算时返回 true 并计数
+  bool is_stale(PipelineStage stage, int64_t capture_us);
 
   bool debug_enabled_;
   std::atomic<bool> is_running_ = false;
   std::atomic<bool> is_paused_ = true;
   std::thread capture_thread_;
-  std::thread decode_thread_;
-  std::thread encode_thread_;
-  std::thread send_thread_;
+  std::thread stats_thread_;
+  std::array<std::unique_ptr<SerialTask>, kPipelineStageCount> stage_tasks_;
+  int queue_stats_interval_ = 0;
+  bool fused_pipeline_ = false;
   TrackCallback track_callback_;
 
   // 多peer支持：使用map存储多个track回调
@@ -75,10 +110,13 @@ protected:
   // 互斥锁用于保护reconfigure等操作
   std::mutex config_mutex_;
 
+  std::array<std::atomic<int64_t>, kPipelineStageCount> stage_budget_us_{};
+  std::array<std::atomic<uint64_t>, kPipelineStageCount> stale_drops_{};
+
   // Queues for async processing
-  SafeQueue<AVPacket *> decode_queue_;
-  SafeQueue<AVFrame *> encode_queue_;
-  SafeQueue<AVPacket *> send_queue_;
+  SafeQueue<TimedPacket> decode_queue_;
+  SafeQueue<TimedFrame> encode_queue_;
+  SafeQueue<TimedPacket> send_queue_;
 };
 
 #endif // CAPTURE_H
\ No newline at end of file
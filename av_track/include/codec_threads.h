@@ -0,0 +1,37 @@
+#ifndef CODEC_THREADS_H
+#define CODEC_THREADS_H
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+// 编解码器的线程配置，需在 avcodec_open2 之前设置到 AVCodecContext
+struct CodecThreading {
+  int thread_count = 1;
+  int thread_type = FF_THREAD_SLICE; // FF_THREAD_FRAME 或 FF_THREAD_SLICE
+};
+
+// 按 CPU 核数和分辨率选择线程数，requested_threads > 0 时直接使用该值。
+// 帧级线程每多一个线程就多一帧延迟，默认只使用 slice 线程；
+// frame_threads 为 true 时以延迟换吞吐，改用帧级线程
+CodecThreading choose_decoder_threading(const AVCodec *codec, int width,
+                                        int height, int requested_threads,
+                                        bool frame_threads);
+CodecThreading choose_encoder_threading(int width, int height,
+                                        int requested_threads,
+                                        bool frame_threads);
+
+// 帧级线程额外引入的延迟帧数，slice 线程为 0
+int codec_threading_delay_frames(const CodecThreading &threading);
+
+void apply_codec_threading(AVCodecContext *context,
+                           const CodecThreading &threading);
+
+// VP9/AV1 按 tile 列并行编码，返回 log2(tile 列数)：每列至少 256 像素宽，
+// 列数不超过线程数
+int tile_columns_log2(int width, int thread_count);
+
+// 用于日志："frame" 或 "slice"
+const char *codec_thread_type_name(int thread_type);
+
+#endif // CODEC_THREADS_H
@@ -1,6 +1,7 @@
 #ifndef ENCODER_H
 #define ENCODER_H
 
+#include <atomic>
 #include <memory>
 #include <string>
 
@@ -33,7 +34,97 @@ public:
 
   virtual bool encode_frame(AVFrame *frame, AVPacket *packet) = 0;
 
+  // 请求下一帧编码为 IDR 关键帧，可由任意线程调用；不支持的编码器忽略该请求
+  virtual void request_keyframe() {}
+
+  // 输入为全范围（JPEG）YUV 时在码流 VUI 中标记 full range，
+  // 解码帧无需转换范围即可直接送入编码器。需在 open_encoder 之前设置
+  void set_full_range(bool full_range) { full_range_ = full_range; }
+  bool full_range() const { return full_range_; }
+
+  // 周期性帧内刷新：帧内宏块按列滚动分布到一个 GOP（1 秒）的各帧中，
+  // 不再周期性输出 IDR，每帧大小更平稳。需在 open_encoder 之前设置
+  void set_intra_refresh(bool intra_refresh) { intra_refresh_ = intra_refresh; }
+  bool intra_refresh() const { return intra_refresh_; }
+
+  // 每个 slice 的最大字节数，按 RTP 分片大小设置后每个 slice 正好是一个 RTP 包，
+  // 不再需要 FU 分片，丢包只影响单个 slice。0 表示不限制。需在 open_encoder 之前设置
+  void set_max_slice_size(int bytes) { max_slice_size_ = bytes; }
+
+  // 编码线程数，0 表示按 CPU 核数和分辨率自动选择；默认使用 slice 线程，
+  // frame_threads 为 true 时改用帧级线程（每个线程多一帧延迟）。需在 open_encoder 之前设置
+  void set_threading(int threads, bool frame_threads) {
+    requested_threads_ = threads;
+    frame_threads_ = frame_threads;
+  }
+
+  // 运行中调整帧率和码率（含 VBV），可由任意线程调用，在编码线程处理下一帧时生效。
+  // 时间基在打开后不能修改，帧率只能降低（由采集端降帧），码率按打开时的帧率折算，
+  // 保持每帧的码率预算。帧率超过打开时的帧率时返回 false，需要重新打开编码器
+  bool update_rate_control(int fps, int64_t bit_rate) {
+    if (!get_context() || fps <= 0 || fps > open_fps_) {
+      return false;
+    }
+    pending_fps_ = fps;
+    pending_bit_rate_ = bit_rate;
+    rate_update_pending_ = true;
+    return true;
+  }
+
 protected:
   Encoder() = default;
+
+  // 由编码线程在送帧前调用，取出待生效的码率（已按帧率折算）；没有更新时返回 false
+  bool take_rate_update(int64_t &bit_rate) {
+    if (!rate_update_pending_.exchange(false)) {
+      return false;
+    }
+    bit_rate = pending_bit_rate_ * open_fps_ / pending_fps_;
+    return true;
+  }
+
+  // 以新码率重新打开编码器，尺寸和帧率不变，用于无法在运行中修改的参数。
+  // 先打开新的上下文，成功后才释放旧的；失败时保留旧编码器并返回 false。
+  // 新编码器的第一帧为 IDR
+  bool reopen_with_bit_rate(int64_t bit_rate) {
+    AVCodecContext *context = get_context();
+    int width = context->width;
+    int height = context->height;
+    int fps = open_fps_;
+    int64_t previous_bit_rate = open_bit_rate_;
+    AVCodecContext *previous = exchange_context(nullptr);
+    if (!previous) {
+      return false;
+    }
+    if (!open_encoder(width, height, fps, bit_rate)) {
+      close_encoder();
+      exchange_context(previous);
+      open_fps_ = fps;
+      open_bit_rate_ = previous_bit_rate;
+      return false;
+    }
+    avcodec_free_context(&previous);
+    return true;
+  }
+
+  // 替换子类持有的编码器上下文并返回原来的上下文，供 reopen_with_bit_rate 使用；
+  // 返回 nullptr 表示不支持重新打开
+  virtual AVCodecContext *exchange_context(AVCodecContext *context) {
+    return nullptr;
+  }
+
+  bool full_range_ = false;
+  bool intra_refresh_ = false;
+  int max_slice_size_ = 0;
+  int requested_threads_ = 0;
+  bool frame_threads_ = false;
+  // 打开时的参数，由子类的 open_encoder 记录
+  int open_fps_ = 0;
+  int64_t open_bit_rate_ = 0;
+
+private:
+  std::atomic<int> pending_fps_{0};
+  std::atomic<int64_t> pending_bit_rate_{0};
+  std::atomic<bool> rate_update_pending_{false};
 };
 #endif // ENCODER_H
\ No newline at end of file
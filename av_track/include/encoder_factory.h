@@ -0,0 +1,26 @@
+#ifndef ENCODER_FACTORY_H
+#define ENCODER_FACTORY_H
+
+#include "encoder.h"
+#include <memory>
+#include <string>
+
+// 视频编码器注册表：新增编码后端只需在 encoder_factory.cpp 的表中加一项，
+// 采集端按名称创建编码器，WebRTC 端按名称选择 SDP 编码和 RTP 打包器
+struct VideoCodecInfo {
+  const char *name;         // 命令行名称：h264、h265、vp8、vp9、av1
+  const char *display_name; // 日志显示名称
+  AVCodecID codec_id;       // 对应的码流类型，用于校验网络输入流
+  std::unique_ptr<Encoder> (*create)(bool debug_enabled);
+};
+
+// 名称未注册时返回 nullptr
+const VideoCodecInfo *find_video_codec(const std::string &name);
+
+// 所有已注册的名称，逗号分隔，用于帮助和错误信息
+std::string video_codec_names();
+
+std::unique_ptr<Encoder> create_video_encoder(const std::string &name,
+                                              bool debug_enabled);
+
+#endif // ENCODER_FACTORY_H
@@ -0,0 +1,90 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 任务优先级：High 车道（音频）总是先于 Normal 车道（视频）被取走
+enum class TaskPriority { High = 0, Normal };
+constexpr size_t kTaskPriorityCount = 2;
+
+// 音视频各流水线阶段共享的 work-stealing 线程池。
+// 每个工作线程有自己的分车道双端队列，本线程提交的任务从队尾取，
+// 空闲线程从其他线程的队头窃取；高优先级车道全部取空后才会看普通车道。
+// 阻塞的设备读取不应提交到这里，仍由各自的采集线程负责
+class Executor {
+public:
+  // thread_count 为 0 时按 CPU 核数创建工作线程
+  explicit Executor(size_t thread_count = 0);
+  ~Executor();
+
+  Executor(const Executor &) = delete;
+  Executor &operator=(const Executor &) = delete;
+
+  // 进程内共享的线程池，第一次调用时创建
+  static Executor &shared();
+
+  void submit(TaskPriority priority, std::function<void()> task);
+  size_t thread_count() const { return workers_.size(); }
+
+  // 并行执行 fn(0) ... fn(count - 1)，全部完成后返回。调用线程自己也参与执行，
+  // 尚未被其他线程取走的部分由调用线程完成，因此可以在任务内部调用而不会死锁
+  void parallel_for(TaskPriority priority, size_t count,
+                    const std::function<void(size_t)> &fn);
+
+private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<std::function<void()>> lanes[kTaskPriorityCount];
+    std::thread thread;
+  };
+
+  void worker_loop(size_t index);
+  bool take_task(size_t index, std::function<void()> &task);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<size_t> next_worker_{0};
+
+  // 空闲线程在此休眠，pending_ 为已提交但尚未取走的任务数
+  std::mutex idle_mutex_;
+  std::condition_variable idle_cv_;
+  std::atomic<size_t> pending_{0};
+  std::atomic<bool> stopping_{false};
+};
+
+// 串行任务：同一时刻最多只有一个线程在执行 step，适合驱动一个队列的消费端
+// （解码器、编码器等上下文不能并发访问，SPSC 队列也只允许一个消费者）。
+// 生产者入队后调用 notify()，没有在运行时才向线程池提交一次执行；
+// step 每次处理有限的一批数据，返回 true 表示还有剩余，会重新排队以便让出线程
+class SerialTask {
+public:
+  SerialTask(Executor &executor, TaskPriority priority,
+             std::function<bool()> step);
+  ~SerialTask();
+
+  void notify();
+  // 不再调度新的执行，并等待正在执行的 step 结束
+  void close();
+
+private:
+  enum State { kIdle = 0, kScheduled, kRunning, kNotified };
+
+  void run();
+
+  Executor &executor_;
+  TaskPriority priority_;
+  std::function<bool()> step_;
+  std::atomic<int> state_{kIdle};
+  std::atomic<bool> closed_{false};
+  std::mutex idle_mutex_;
+  std::condition_variable idle_cv_;
+};
+
+#endif // EXECUTOR_H
@@ -0,0 +1,67 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <algorithm>
+#include <cstdint>
+
+// 按时间戳降低帧率：维护下一帧的目标时刻，每保留一帧目标时刻前进一个输出间隔，
+// 小数部分的误差自然累积，输出帧率准确且间隔均匀（30->20 保留 3 帧中的 2 帧，
+// 而不是按取整后的倍数变成 15）。只在单个线程中使用
+class FramePacer {
+public:
+  // fps <= 0 表示不限制，所有帧都保留
+  void set_target_fps(int fps) {
+    target_fps_ = fps > 0 ? fps : 0;
+    interval_us_ = target_fps_ > 0 ? 1000000 / target_fps_ : 0;
+    reset();
+  }
+  int target_fps() const { return target_fps_; }
+
+  void reset() {
+    next_due_us_ = -1;
+    last_input_us_ = -1;
+    input_interval_us_ = 0;
+  }
+
+  // 根据帧的采集时间判断是否保留该帧
+  bool should_keep(int64_t timestamp_us) {
+    if (interval_us_ <= 0) {
+      return true;
+    }
+
+    // 估计输入帧间隔（指数平均），用来选择离目标时刻最近的一帧
+    if (last_input_us_ >= 0 && timestamp_us > last_input_us_) {
+      int64_t delta = timestamp_us - last_input_us_;
+      input_interval_us_ = input_interval_us_ == 0
+                               ? delta
+                               : (input_interval_us_ * 7 + delta) / 8;
+    }
+    last_input_us_ = timestamp_us;
+
+    if (next_due_us_ < 0 || timestamp_us - next_due_us_ > interval_us_) {
+      // 第一帧，或暂停/断流后落后超过一个间隔：从当前帧重新开始计时
+      next_due_us_ = timestamp_us + interval_us_;
+      return true;
+    }
+
+    // 下一输入帧会更接近目标时刻时丢弃当前帧
+    int64_t tolerance =
+        (input_interval_us_ > 0 ? std::min(input_interval_us_, interval_us_)
+                                : interval_us_) /
+        2;
+    if (timestamp_us + tolerance < next_due_us_) {
+      return false;
+    }
+    next_due_us_ += interval_us_;
+    return true;
+  }
+
+private:
+  int target_fps_ = 0;
+  int64_t interval_us_ = 0;
+  int64_t next_due_us_ = -1;
+  int64_t last_input_us_ = -1;
+  int64_t input_interval_us_ = 0;
+};
+
+#endif // FRAME_PACER_H
@@ -1,4 +1,6 @@
 #include "encoder.h"
+#include <atomic>
+#include <utility>
 #ifndef H264_ENCODER_H
 #define H264_ENCODER_H
 class H264Encoder : public Encoder {
@@ -12,10 +14,18 @@ public:
   AVCodecContext *get_context() const override { return encoder_context_; }
 
   bool encode_frame(AVFrame *frame, AVPacket *packet) override;
+  void request_keyframe() override { keyframe_requested_ = true; }
+
+protected:
+  AVCodecContext *exchange_context(AVCodecContext *context) override {
+    std::swap(context, encoder_context_);
+    return context;
+  }
 
 private:
   bool debug_enabled_;
   AVCodecContext *encoder_context_;
   const AVCodec *codec_;
+  std::atomic<bool> keyframe_requested_{false};
 };
 #endif // H264_ENCODER_H
@@ -0,0 +1,64 @@
+#ifndef H264_NAL_H
+#define H264_NAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+// H.264 NAL 单元类型
+enum H264NalType : uint8_t {
+  kH264NalIdr = 5,
+  kH264NalSps = 7,
+  kH264NalPps = 8,
+  kH264NalAud = 9,
+};
+
+// 遍历 Annex-B 码流中的 NAL 单元（不含起始码），fn(type, data, size)
+template <typename Fn>
+void for_each_h264_nal(const uint8_t *data, size_t size, Fn &&fn) {
+  size_t i = 0;
+  size_t nal_start = SIZE_MAX;
+  while (i + 3 <= size) {
+    if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+      if (nal_start != SIZE_MAX) {
+        // 去掉四字节起始码的前导 0
+        size_t nal_end = i;
+        if (nal_end > nal_start && data[nal_end - 1] == 0) {
+          --nal_end;
+        }
+        fn(data[nal_start] & 0x1f, data + nal_start, nal_end - nal_start);
+      }
+      i += 3;
+      nal_start = i;
+    } else {
+      ++i;
+    }
+  }
+  if (nal_start != SIZE_MAX && nal_start < size) {
+    fn(data[nal_start] & 0x1f, data + nal_start, size - nal_start);
+  }
+}
+
+// 判断一个 Annex-B 访问单元是否包含 IDR 片
+bool h264_has_idr(const uint8_t *data, size_t size);
+
+// 缓存码流中最近的 SPS/PPS，在不带参数集的 IDR 前补上，
+// 保证新加入的 peer 从任意一个 IDR 开始都能解码。
+// 很多 UVC H.264 摄像头只在开流时输出一次 SPS/PPS
+class H264ParameterSets {
+public:
+  // 扫描并缓存 packet 中的 SPS/PPS；packet 为不带参数集的 IDR 时在其前面插入缓存的参数集
+  void process(AVPacket *packet);
+  bool ready() const { return !sps_.empty() && !pps_.empty(); }
+  void clear();
+
+private:
+  std::vector<uint8_t> sps_;
+  std::vector<uint8_t> pps_;
+};
+
+#endif // H264_NAL_H
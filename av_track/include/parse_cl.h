@@ -50,7 +50,7 @@ private:
   int _c;                     // Audio channels
   std::string _f;             // Audio input_format
   std::string _videoFormat;   // Video input format
-  std::string _videoCodec;    // Video codec (h264 or h265)
+  std::string _videoCodec;    // Video codec (h264, h265, vp8, vp9 or av1)
   bool _h;
   std::string _client_id;  // 新添加的client_id参数
   bool _debug;             // 新添加的debug参数
@@ -62,6 +62,24 @@ private:
   int _out_channels;    // Audio output channels
   float _volume;        // Audio volume control
 
+  int _queueStats; // 队列统计输出间隔（秒），0 表示关闭
+  int _decodeBudget; // 解码阶段时延预算（毫秒），0 表示不限制
+  int _encodeBudget; // 编码阶段时延预算（毫秒）
+  int _sendBudget;   // 发送阶段时延预算（毫秒）
+  bool _fusedPipeline; // 解码/缩放/编码合并到同一个任务
+  bool _cameraPassthrough; // 直接转发摄像头输出的 H.264
+  std::string _outResolution; // 编码输出分辨率，为空时与采集分辨率相同
+  int _scaleThreads; // 并行缩放的条带数，0 为自动
+  int _rotation;     // 顺时针旋转角度
+  bool _mirror;      // 旋转后水平镜像
+  int _idleGrace;    // 无观看者后摄像头保持热备的秒数
+  bool _intraRefresh; // 周期性帧内刷新代替周期性 IDR
+  bool _noJoinIdr;    // 帧内刷新模式下新观看者加入时不强制 IDR
+  bool _lowLatencySlices; // 低延迟模式：按 RTP 包大小切分 slice，只用 slice 线程
+  int _decoderThreads;    // 解码线程数，0 为自动
+  int _encoderThreads;    // 编码线程数，0 为自动
+  bool _frameThreads;     // 编解码使用帧级线程，每个线程多一帧延迟
+
   /* other stuff to keep track of */
   std::string _program_name;
   int _optind;
@@ -102,7 +120,7 @@ public:
   } // Video input format getter
   std::string videoCodec() const {
     return _videoCodec;
-  } // Video codec getter (h264 or h265)
+  } // Video codec getter (h264, h265, vp8, vp9 or av1)
   bool h() const { return _h; }
   std::string clientId() const {
     return _client_id;
@@ -117,6 +135,24 @@ public:
   int outSampleRate() const { return _out_sample_rate; }
   int outChannels() const { return _out_channels; }
   float volume() const { return _volume; }
+
+  int queueStatsInterval() const { return _queueStats; }
+  int decodeBudget() const { return _decodeBudget; }
+  int encodeBudget() const { return _encodeBudget; }
+  int sendBudget() const { return _sendBudget; }
+  bool fusedPipeline() const { return _fusedPipeline; }
+  bool cameraPassthrough() const { return _cameraPassthrough; }
+  std::string outResolution() const { return _outResolution; }
+  int scaleThreads() const { return _scaleThreads; }
+  int rotation() const { return _rotation; }
+  bool mirror() const { return _mirror; }
+  int idleGrace() const { return _idleGrace; }
+  bool intraRefresh() const { return _intraRefresh; }
+  bool noJoinIdr() const { return _noJoinIdr; }
+  bool lowLatencySlices() const { return _lowLatencySlices; }
+  int decoderThreads() const { return _decoderThreads; }
+  int encoderThreads() const { return _encoderThreads; }
+  bool frameThreads() const { return _frameThreads; }
 };
 
 #endif
\ No newline at end of file
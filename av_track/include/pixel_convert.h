@@ -0,0 +1,36 @@
+#ifndef PIXEL_CONVERT_H
+#define PIXEL_CONVERT_H
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+}
+
+// 常见摄像头格式（YUYV422、NV12）到 YUV420P 的手写 SIMD 转换，以及 YUV420P 的旋转/镜像。
+// 只覆盖同尺寸转换和宽高各缩小一半两种情况，其余情况仍由 sws_scale 处理。
+// 运行时按 CPU 选择 AVX2/SSE2（x86）或 NEON（ARM），都不可用时使用标量实现。
+// 缩小一半时使用 2x2 均值；SIMD 实现可能因两次舍入与标量结果相差 1
+
+// 返回当前使用的实现名称：avx2、sse2、neon 或 scalar
+const char *fast_convert_kernel_name();
+
+// 测试和基准使用：强制使用指定实现（avx2、sse2、neon、scalar），
+// 名称未知或当前 CPU 不支持时返回 false；传入 nullptr 恢复自动选择
+bool set_fast_convert_kernel(const char *name);
+
+// 判断给定的源/目标格式和尺寸能否使用快速转换
+bool fast_convert_supported(AVPixelFormat src_format, int src_width,
+                            int src_height, AVPixelFormat dst_format,
+                            int dst_width, int dst_height);
+
+// 将 src 转换到已分配好缓冲区的 dst，格式或尺寸不支持时返回 false
+bool fast_convert_frame(const AVFrame *src, AVFrame *dst);
+
+// 旋转 90/270 度时输出的宽高互换
+bool rotation_swaps_dimensions(int rotation);
+
+// 将 YUV420P 帧顺时针旋转 rotation 度（0/90/180/270），mirror 为 true 时
+// 再做水平镜像。dst 需已按旋转后的尺寸分配，不支持时返回 false
+bool rotate_frame(const AVFrame *src, AVFrame *dst, int rotation, bool mirror);
+
+#endif // PIXEL_CONVERT_H
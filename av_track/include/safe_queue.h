@@ -1,40 +1,124 @@
 #ifndef SAFE_QUEUE_H
 #define SAFE_QUEUE_H
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <climits>
 #include <condition_variable>
-#include <functional>
-#include <memory>
+#include <cstdint>
 #include <mutex>
 #include <vector>
-#include <atomic>
 
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// 队列后端：
+//  - Locked: mutex + condition_variable，支持任意数量的生产者/消费者
+//  - Spsc:   无锁环形缓冲区，仅允许一个生产者线程和一个消费者线程；
+//            只有当对端确实在等待时才通过 futex 唤醒
+enum class QueueBackend { Locked, Spsc };
+
+// 队列满时 try_push 的处理策略：
+//  - Reject:     返回 false，元素仍归调用方所有（默认，与旧行为一致）
+//  - DropNewest: 丢弃新元素
+//  - DropOldest: 丢弃最旧的元素为新元素腾出空间（仅 Locked 后端支持）
+//  - Mailbox:    只保留最新的 N 个元素，消费者总是拿到最新的数据（仅 Locked 后端支持）
+// 除 Reject 外，try_push 总是接管元素的所有权，返回值仅表示该元素是否入队
+enum class OverflowPolicy { Reject, DropNewest, DropOldest, Mailbox };
+
+// 队列统计快照。计数器均为 relaxed 原子量，只在真正阻塞时才读取时钟，
+// 快速路径上没有额外的系统调用
+struct QueueStats {
+  // 阻塞时长直方图：各桶上界（微秒），最后一个桶收集 >= 100ms 的等待
+  static constexpr size_t kWaitBuckets = 6;
+  static constexpr uint64_t kWaitBucketUpperUs[kWaitBuckets - 1] = {
+      100, 1000, 5000, 20000, 100000};
+
+  uint64_t pushes = 0;  // 成功入队的元素数
+  uint64_t pops = 0;    // 成功出队的元素数
+  uint64_t drops = 0;   // 按溢出策略被队列丢弃的元素数
+  uint64_t rejects = 0; // Reject 策略下因队列满而退回给调用方的次数
+  size_t size = 0;
+  size_t capacity = 0;
+  size_t high_water = 0; // 统计周期内的最大队列深度
+  std::array<uint64_t, kWaitBuckets> producer_wait{}; // wait_push 阻塞时长
+  std::array<uint64_t, kWaitBuckets> consumer_wait{}; // wait_pop* 阻塞时长
+};
+
+// T 为只可移动的 RAII 句柄（如 AVPacketPtr/AVFramePtr），
+// 队列丢弃或清空元素时直接销毁句柄，不再需要单独的 deleter
 template <typename T> class SafeQueue {
 public:
-  using DeleterFunc = std::function<void(T&)>;
-
   // Circular buffer backed by std::vector with fixed capacity
-  explicit SafeQueue(size_t capacity = 256, DeleterFunc deleter = nullptr);
+  explicit SafeQueue(size_t capacity = 256,
+                     QueueBackend backend = QueueBackend::Locked);
   ~SafeQueue();
 
   // Blocking wait_push when full to avoid dropping or leaking items managed by
-  // caller
+  // caller. 非 Reject 策略下不会阻塞，按策略丢弃
   void wait_push(T item);
 
   bool try_push(T item);
   bool try_pop(T &item);
   void wait_pop(T &item);
 
+  // 批量接口：整批只加一次锁（Spsc 后端只发布一次索引），只唤醒一次对端。
+  // try_push_bulk 返回入队数量；已入队的元素从 items 中移除，Reject 策略下
+  // 剩余元素仍留在 items 中归调用方所有，其他策略下剩余元素被丢弃，items 清空
+  size_t try_push_bulk(std::vector<T> &items);
+  // 追加最多 max_items 个元素到 out，返回出队数量
+  size_t try_pop_bulk(std::vector<T> &out, size_t max_items);
+  // 阻塞直到至少有一个元素；队列停止且为空时返回 0
+  size_t wait_pop_bulk(std::vector<T> &out, size_t max_items);
+
   bool empty() const;
   size_t size() const;
   size_t capacity() const;
+  QueueBackend backend() const { return backend_; }
 
-  void set_deleter(DeleterFunc deleter);
+  // 需在队列被多个线程使用前调用；
+  // Spsc 后端不支持 DropOldest 和 Mailbox，此时会退回 Locked 后端
+  void set_overflow_policy(OverflowPolicy policy, size_t mailbox_depth = 1);
+  OverflowPolicy overflow_policy() const { return policy_; }
+  // Spsc 后端下 clear() 可由任意线程调用：只记录丢弃位置，
+  // 实际释放由消费者线程在下一次出队时完成
   void clear();
 
   // 停止队列：清空现有元素并唤醒所有等待线程，使其尽快退出
   void stop();
 
+  // 可由任意线程调用；reset_stats() 清零计数器并开始新的统计周期
+  QueueStats stats() const;
+  void reset_stats();
+
 private:
+  using Clock = std::chrono::steady_clock;
+  using WaitHistogram =
+      std::array<std::atomic<uint64_t>, QueueStats::kWaitBuckets>;
+
+  void drop_item(T &item);
+  void note_depth(size_t depth);
+  void finish_wait(WaitHistogram &histogram, Clock::time_point start);
+
+  // Locked backend helpers, 调用方需持有 mutex_
+  bool locked_push(T &item);
+  size_t locked_pop_bulk(std::vector<T> &out, size_t max_items);
+
+  // Spsc backend helpers
+  size_t spsc_push_range(T *items, size_t n);
+  size_t spsc_pop_range(T *out, size_t n);
+  void spsc_park_consumer();
+  void spsc_park_producer();
+  void spsc_destroy(size_t index);
+  void spsc_drain();
+  void park(std::atomic<uint32_t> &seq, uint32_t expected);
+  void unpark(std::atomic<uint32_t> &seq);
+
   mutable std::mutex mutex_;
   std::condition_variable condition_;
   size_t capacity_;
@@ -42,8 +126,552 @@ private:
   size_t head_;
   size_t tail_;
   size_t count_;
-  DeleterFunc deleter_;
   std::atomic<bool> is_running_;
+  QueueBackend backend_;
+  OverflowPolicy policy_ = OverflowPolicy::Reject;
+  size_t mailbox_depth_ = 1;
+
+  // Spsc backend: 单调递增的读写索引，分别独占一条 cache line 以避免伪共享
+  static constexpr size_t kCacheLineSize = 64;
+  alignas(kCacheLineSize) std::atomic<size_t> spsc_head_{0}; // 消费者写
+  alignas(kCacheLineSize) std::atomic<size_t> spsc_tail_{0}; // 生产者写
+  alignas(kCacheLineSize) std::atomic<size_t> spsc_discard_until_{0};
+  std::atomic<uint32_t> items_seq_{0};  // 消费者等待数据时的 futex 字
+  std::atomic<uint32_t> space_seq_{0};  // 生产者等待空位时的 futex 字
+  std::atomic<bool> consumer_parked_{false};
+  std::atomic<bool> producer_parked_{false};
+
+  // 统计计数器：生产者侧与消费者侧分开放置，避免两端互相失效 cache line
+  alignas(kCacheLineSize) std::atomic<uint64_t> stat_pushes_{0};
+  std::atomic<uint64_t> stat_drops_{0};
+  std::atomic<uint64_t> stat_rejects_{0};
+  std::atomic<size_t> stat_high_water_{0};
+  WaitHistogram stat_producer_wait_{};
+  alignas(kCacheLineSize) std::atomic<uint64_t> stat_pops_{0};
+  WaitHistogram stat_consumer_wait_{};
 };
 
+template <typename T>
+SafeQueue<T>::SafeQueue(size_t capacity, QueueBackend backend)
+    : capacity_(capacity == 0 ? 1 : capacity),
+      buffer_(capacity_ > 0 ? capacity_ : 1), head_(0), tail_(0), count_(0),
+      is_running_(true), backend_(backend) {}
+
+template <typename T> SafeQueue<T>::~SafeQueue() {
+  if (backend_ == QueueBackend::Spsc) {
+    // 析构时生产者和消费者线程都已退出，可以直接释放剩余元素
+    spsc_drain();
+    return;
+  }
+  clear();
+}
+
+template <typename T> void SafeQueue<T>::wait_push(T item) {
+  if (policy_ != OverflowPolicy::Reject) {
+    try_push(std::move(item));
+    return;
+  }
+
+  Clock::time_point wait_start{};
+  if (backend_ == QueueBackend::Spsc) {
+    while (is_running_) {
+      if (spsc_push_range(&item, 1) == 1) {
+        finish_wait(stat_producer_wait_, wait_start);
+        return;
+      }
+      if (wait_start == Clock::time_point{}) {
+        wait_start = Clock::now();
+      }
+      spsc_park_producer();
+    }
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (count_ >= capacity_ && is_running_) {
+    wait_start = Clock::now();
+    condition_.wait(lock,
+                    [this] { return count_ < capacity_ || !is_running_; });
+    finish_wait(stat_producer_wait_, wait_start);
+  }
+  if (!locked_push(item)) {
+    return;
+  }
+  lock.unlock();
+  condition_.notify_one();
+}
+
+template <typename T> bool SafeQueue<T>::try_push(T item) {
+  bool pushed = false;
+  if (backend_ == QueueBackend::Spsc) {
+    pushed = is_running_ && spsc_push_range(&item, 1) == 1;
+  } else {
+    std::unique_lock<std::mutex> lock(mutex_);
+    pushed = locked_push(item);
+    lock.unlock();
+    if (pushed) {
+      condition_.notify_one();
+    }
+  }
+
+  if (!pushed && policy_ != OverflowPolicy::Reject) {
+    stat_drops_.fetch_add(1, std::memory_order_relaxed);
+    drop_item(item);
+  } else if (!pushed) {
+    stat_rejects_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return pushed;
+}
+
+template <typename T> size_t SafeQueue<T>::try_push_bulk(std::vector<T> &items) {
+  size_t pushed = 0;
+  if (backend_ == QueueBackend::Spsc) {
+    if (is_running_ && !items.empty()) {
+      pushed = spsc_push_range(items.data(), items.size());
+    }
+  } else {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (pushed < items.size() && locked_push(items[pushed])) {
+      ++pushed;
+    }
+    lock.unlock();
+    // 整批只唤醒一次消费者
+    if (pushed > 0) {
+      condition_.notify_one();
+    }
+  }
+
+  if (policy_ != OverflowPolicy::Reject) {
+    stat_drops_.fetch_add(items.size() - pushed, std::memory_order_relaxed);
+    for (size_t i = pushed; i < items.size(); ++i) {
+      drop_item(items[i]);
+    }
+    items.clear();
+  } else {
+    if (pushed < items.size()) {
+      stat_rejects_.fetch_add(1, std::memory_order_relaxed);
+    }
+    items.erase(items.begin(), items.begin() + pushed);
+  }
+  return pushed;
+}
+
+template <typename T> bool SafeQueue<T>::try_pop(T &item) {
+  if (backend_ == QueueBackend::Spsc) {
+    return spsc_pop_range(&item, 1) == 1;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (count_ == 0) {
+    return false;
+  }
+  item = std::move(buffer_[head_]);
+  head_ = (head_ + 1) % capacity_;
+  --count_;
+  lock.unlock();
+  stat_pops_.fetch_add(1, std::memory_order_relaxed);
+  condition_.notify_one();
+  return true;
+}
+
+template <typename T> void SafeQueue<T>::wait_pop(T &item) {
+  Clock::time_point wait_start{};
+  if (backend_ == QueueBackend::Spsc) {
+    for (;;) {
+      if (spsc_pop_range(&item, 1) == 1) {
+        finish_wait(stat_consumer_wait_, wait_start);
+        return;
+      }
+      if (!is_running_) {
+        item = T{};
+        return;
+      }
+      if (wait_start == Clock::time_point{}) {
+        wait_start = Clock::now();
+      }
+      spsc_park_consumer();
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (count_ == 0 && is_running_) {
+    wait_start = Clock::now();
+    condition_.wait(lock, [this] { return count_ > 0 || !is_running_; });
+    finish_wait(stat_consumer_wait_, wait_start);
+  }
+  if (count_ == 0) {
+    // 队列已停止且为空，返回一个默认值（对于指针类型即为 nullptr）
+    item = T{};
+    return;
+  }
+  item = std::move(buffer_[head_]);
+  head_ = (head_ + 1) % capacity_;
+  --count_;
+  lock.unlock();
+  stat_pops_.fetch_add(1, std::memory_order_relaxed);
+  condition_.notify_one();
+}
+
+template <typename T>
+size_t SafeQueue<T>::try_pop_bulk(std::vector<T> &out, size_t max_items) {
+  if (max_items == 0) {
+    return 0;
+  }
+  if (backend_ == QueueBackend::Spsc) {
+    size_t start = out.size();
+    out.resize(start + std::min(max_items, capacity_));
+    size_t popped = spsc_pop_range(out.data() + start, out.size() - start);
+    out.resize(start + popped);
+    return popped;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  size_t popped = locked_pop_bulk(out, max_items);
+  lock.unlock();
+  if (popped > 0) {
+    condition_.notify_one();
+  }
+  return popped;
+}
+
+template <typename T>
+size_t SafeQueue<T>::wait_pop_bulk(std::vector<T> &out, size_t max_items) {
+  if (max_items == 0) {
+    return 0;
+  }
+  Clock::time_point wait_start{};
+  if (backend_ == QueueBackend::Spsc) {
+    for (;;) {
+      size_t popped = try_pop_bulk(out, max_items);
+      if (popped > 0 || !is_running_) {
+        finish_wait(stat_consumer_wait_, wait_start);
+        return popped;
+      }
+      if (wait_start == Clock::time_point{}) {
+        wait_start = Clock::now();
+      }
+      spsc_park_consumer();
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (count_ == 0 && is_running_) {
+    wait_start = Clock::now();
+    condition_.wait(lock, [this] { return count_ > 0 || !is_running_; });
+    finish_wait(stat_consumer_wait_, wait_start);
+  }
+  size_t popped = locked_pop_bulk(out, max_items);
+  lock.unlock();
+  if (popped > 0) {
+    condition_.notify_one();
+  }
+  return popped;
+}
+
+template <typename T> bool SafeQueue<T>::empty() const {
+  if (backend_ == QueueBackend::Spsc) {
+    return size() == 0;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  return count_ == 0;
+}
+
+template <typename T> size_t SafeQueue<T>::size() const {
+  if (backend_ == QueueBackend::Spsc) {
+    size_t head = std::max(spsc_head_.load(std::memory_order_acquire),
+                           spsc_discard_until_.load(std::memory_order_acquire));
+    size_t tail = spsc_tail_.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  return count_;
+}
+
+template <typename T> size_t SafeQueue<T>::capacity() const {
+  return capacity_;
+}
+
+template <typename T>
+void SafeQueue<T>::set_overflow_policy(OverflowPolicy policy,
+                                       size_t mailbox_depth) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  policy_ = policy;
+  mailbox_depth_ = std::max<size_t>(1, std::min(mailbox_depth, capacity_));
+  // Spsc 后端中只有消费者可以推进队首，生产者无法丢弃最旧的元素，
+  // 环形缓冲区满时只能丢弃最新的元素，与 Mailbox 的语义相反
+  if ((policy_ == OverflowPolicy::DropOldest ||
+       policy_ == OverflowPolicy::Mailbox) &&
+      backend_ == QueueBackend::Spsc) {
+    backend_ = QueueBackend::Locked;
+  }
+}
+
+template <typename T> QueueStats SafeQueue<T>::stats() const {
+  QueueStats stats;
+  stats.pushes = stat_pushes_.load(std::memory_order_relaxed);
+  stats.pops = stat_pops_.load(std::memory_order_relaxed);
+  stats.drops = stat_drops_.load(std::memory_order_relaxed);
+  stats.rejects = stat_rejects_.load(std::memory_order_relaxed);
+  stats.size = size();
+  stats.capacity = capacity_;
+  stats.high_water = stat_high_water_.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < QueueStats::kWaitBuckets; ++i) {
+    stats.producer_wait[i] =
+        stat_producer_wait_[i].load(std::memory_order_relaxed);
+    stats.consumer_wait[i] =
+        stat_consumer_wait_[i].load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+template <typename T> void SafeQueue<T>::reset_stats() {
+  stat_pushes_.store(0, std::memory_order_relaxed);
+  stat_pops_.store(0, std::memory_order_relaxed);
+  stat_drops_.store(0, std::memory_order_relaxed);
+  stat_rejects_.store(0, std::memory_order_relaxed);
+  // 新周期的高水位从当前深度开始
+  stat_high_water_.store(size(), std::memory_order_relaxed);
+  for (size_t i = 0; i < QueueStats::kWaitBuckets; ++i) {
+    stat_producer_wait_[i].store(0, std::memory_order_relaxed);
+    stat_consumer_wait_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+template <typename T> void SafeQueue<T>::note_depth(size_t depth) {
+  size_t high_water = stat_high_water_.load(std::memory_order_relaxed);
+  while (depth > high_water &&
+         !stat_high_water_.compare_exchange_weak(high_water, depth,
+                                                 std::memory_order_relaxed)) {
+  }
+}
+
+template <typename T>
+void SafeQueue<T>::finish_wait(WaitHistogram &histogram,
+                               Clock::time_point start) {
+  if (start == Clock::time_point{}) {
+    return; // 没有阻塞过
+  }
+  auto waited_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                       Clock::now() - start)
+                       .count();
+  size_t bucket = 0;
+  while (bucket < QueueStats::kWaitBuckets - 1 &&
+         static_cast<uint64_t>(waited_us) >=
+             QueueStats::kWaitBucketUpperUs[bucket]) {
+    ++bucket;
+  }
+  histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename T> void SafeQueue<T>::drop_item(T &item) {
+  // 元素为 RAII 句柄，赋空值即释放
+  item = T{};
+}
+
+template <typename T> void SafeQueue<T>::clear() {
+  if (backend_ == QueueBackend::Spsc) {
+    // 只推进丢弃位置（取最大值），由消费者在出队时释放这些元素
+    size_t tail = spsc_tail_.load(std::memory_order_acquire);
+    size_t current = spsc_discard_until_.load(std::memory_order_relaxed);
+    while (current < tail &&
+           !spsc_discard_until_.compare_exchange_weak(
+               current, tail, std::memory_order_release,
+               std::memory_order_relaxed)) {
+    }
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t i = 0; i < count_; ++i) {
+    size_t index = (head_ + i) % capacity_;
+    drop_item(buffer_[index]);
+  }
+  head_ = 0;
+  tail_ = 0;
+  count_ = 0;
+  // 保持运行状态，仅清空队列
+  condition_.notify_all();
+}
+
+template <typename T> void SafeQueue<T>::stop() {
+  if (backend_ == QueueBackend::Spsc) {
+    is_running_ = false;
+    clear();
+    // 无条件唤醒两端，等待中的线程会看到 is_running_ == false
+    unpark(items_seq_);
+    unpark(space_seq_);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t i = 0; i < count_; ++i) {
+    size_t index = (head_ + i) % capacity_;
+    drop_item(buffer_[index]);
+  }
+  head_ = 0;
+  tail_ = 0;
+  count_ = 0;
+  is_running_ = false;
+  condition_.notify_all();
+}
+
+template <typename T> bool SafeQueue<T>::locked_push(T &item) {
+  if (!is_running_) {
+    return false;
+  }
+  size_t limit = policy_ == OverflowPolicy::Mailbox ? mailbox_depth_ : capacity_;
+  if (count_ >= limit && (policy_ == OverflowPolicy::DropOldest ||
+                          policy_ == OverflowPolicy::Mailbox)) {
+    // 在同一把锁内丢弃最旧的元素，为新元素腾出空间
+    while (count_ >= limit) {
+      drop_item(buffer_[head_]);
+      head_ = (head_ + 1) % capacity_;
+      --count_;
+      stat_drops_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  if (count_ >= limit) {
+    return false;
+  }
+  buffer_[tail_] = std::move(item);
+  tail_ = (tail_ + 1) % capacity_;
+  ++count_;
+  stat_pushes_.fetch_add(1, std::memory_order_relaxed);
+  note_depth(count_);
+  return true;
+}
+
+template <typename T>
+size_t SafeQueue<T>::locked_pop_bulk(std::vector<T> &out, size_t max_items) {
+  size_t popped = std::min(count_, max_items);
+  out.reserve(out.size() + popped);
+  for (size_t i = 0; i < popped; ++i) {
+    out.push_back(std::move(buffer_[head_]));
+    head_ = (head_ + 1) % capacity_;
+  }
+  count_ -= popped;
+  stat_pops_.fetch_add(popped, std::memory_order_relaxed);
+  return popped;
+}
+
+template <typename T>
+size_t SafeQueue<T>::spsc_push_range(T *items, size_t n) {
+  size_t tail = spsc_tail_.load(std::memory_order_relaxed);
+  size_t used = tail - spsc_head_.load(std::memory_order_acquire);
+  size_t pushed = std::min(n, capacity_ - used);
+  if (pushed == 0) {
+    return 0;
+  }
+  for (size_t i = 0; i < pushed; ++i) {
+    buffer_[(tail + i) % capacity_] = std::move(items[i]);
+  }
+  spsc_tail_.store(tail + pushed, std::memory_order_release);
+  stat_pushes_.fetch_add(pushed, std::memory_order_relaxed);
+  note_depth(used + pushed);
+
+  // 只有消费者确实在等待时才进行系统调用，整批只唤醒一次
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (consumer_parked_.load(std::memory_order_relaxed)) {
+    unpark(items_seq_);
+  }
+  return pushed;
+}
+
+template <typename T> size_t SafeQueue<T>::spsc_pop_range(T *out, size_t n) {
+  size_t head = spsc_head_.load(std::memory_order_relaxed);
+  size_t tail = spsc_tail_.load(std::memory_order_acquire);
+  size_t discard_until = spsc_discard_until_.load(std::memory_order_acquire);
+
+  // 先处理 clear() 请求丢弃的元素
+  while (head < discard_until && head < tail) {
+    spsc_destroy(head % capacity_);
+    ++head;
+  }
+
+  size_t popped = std::min(n, tail - head);
+  for (size_t i = 0; i < popped; ++i) {
+    out[i] = std::move(buffer_[(head + i) % capacity_]);
+  }
+  head += popped;
+  if (popped > 0) {
+    stat_pops_.fetch_add(popped, std::memory_order_relaxed);
+  }
+
+  if (head != spsc_head_.load(std::memory_order_relaxed)) {
+    spsc_head_.store(head, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (producer_parked_.load(std::memory_order_relaxed)) {
+      unpark(space_seq_);
+    }
+  }
+  return popped;
+}
+
+template <typename T> void SafeQueue<T>::spsc_park_consumer() {
+  // 队列为空：登记等待后再次检查，避免与生产者的唤醒错过
+  uint32_t seq = items_seq_.load(std::memory_order_acquire);
+  consumer_parked_.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (spsc_tail_.load(std::memory_order_acquire) ==
+          spsc_head_.load(std::memory_order_relaxed) &&
+      is_running_) {
+    park(items_seq_, seq);
+  }
+  consumer_parked_.store(false, std::memory_order_relaxed);
+}
+
+template <typename T> void SafeQueue<T>::spsc_park_producer() {
+  // 队列已满：登记等待后再次检查，避免与消费者的唤醒错过
+  uint32_t seq = space_seq_.load(std::memory_order_acquire);
+  producer_parked_.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (spsc_tail_.load(std::memory_order_relaxed) -
+              spsc_head_.load(std::memory_order_acquire) >=
+          capacity_ &&
+      is_running_) {
+    park(space_seq_, seq);
+  }
+  producer_parked_.store(false, std::memory_order_relaxed);
+}
+
+template <typename T> void SafeQueue<T>::spsc_destroy(size_t index) {
+  drop_item(buffer_[index]);
+}
+
+template <typename T> void SafeQueue<T>::spsc_drain() {
+  size_t head = spsc_head_.load(std::memory_order_acquire);
+  size_t tail = spsc_tail_.load(std::memory_order_acquire);
+  for (; head < tail; ++head) {
+    spsc_destroy(head % capacity_);
+  }
+  spsc_head_.store(head, std::memory_order_release);
+}
+
+template <typename T>
+void SafeQueue<T>::park(std::atomic<uint32_t> &seq, uint32_t expected) {
+#ifdef __linux__
+  // seq 已变化时 FUTEX_WAIT 立即返回，因此不会错过唤醒
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&seq), FUTEX_WAIT_PRIVATE,
+          expected, nullptr, nullptr, 0);
+#else
+  std::unique_lock<std::mutex> lock(mutex_);
+  condition_.wait_for(lock, std::chrono::milliseconds(1), [&] {
+    return seq.load(std::memory_order_acquire) != expected;
+  });
+#endif
+}
+
+template <typename T> void SafeQueue<T>::unpark(std::atomic<uint32_t> &seq) {
+  seq.fetch_add(1, std::memory_order_release);
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&seq), FUTEX_WAKE_PRIVATE,
+          INT_MAX, nullptr, nullptr, 0);
+#else
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+  }
+  condition_.notify_all();
+#endif
+}
+
 #endif // SAFE_QUEUE_H
@@ -0,0 +1,55 @@
+#ifndef SLICE_SCALER_H
+#define SLICE_SCALER_H
+
+#include <vector>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+
+// 按水平条带并行缩放：每个条带有独立的 SwsContext，把源图像对应的行范围
+// 缩放到目标图像的对应行范围，各条带在共享线程池上并行执行。
+// 条带边界处的插值只使用本条带内的源行，与整帧 sws_scale 相比边界行略有差异
+class SliceScaler {
+public:
+  SliceScaler() = default;
+  ~SliceScaler();
+
+  SliceScaler(const SliceScaler &) = delete;
+  SliceScaler &operator=(const SliceScaler &) = delete;
+
+  // slices 为 0 时自动选择（最多 4 个），1 为单线程；full_range 为 true 时输出全范围 YUV
+  bool init(int src_width, int src_height, AVPixelFormat src_format,
+            int dst_width, int dst_height, AVPixelFormat dst_format,
+            int slices, bool full_range);
+  void reset();
+  // 与另一个缩放器交换全部状态，用于在帧边界切换到预先建好的缩放器
+  void swap(SliceScaler &other);
+
+  bool is_initialized() const { return !bands_.empty(); }
+  // 当前上下文是否按给定的源尺寸/格式创建
+  bool matches(int src_width, int src_height, AVPixelFormat src_format) const;
+  size_t slice_count() const { return bands_.size(); }
+
+  void scale(const AVFrame *src, AVFrame *dst);
+
+private:
+  struct Band {
+    SwsContext *context;
+    int src_y;
+    int src_height;
+    int dst_y;
+    int dst_height;
+  };
+
+  void scale_band(const Band &band, const AVFrame *src, AVFrame *dst) const;
+
+  std::vector<Band> bands_;
+  int src_width_ = 0;
+  int src_height_ = 0;
+  AVPixelFormat src_format_ = AV_PIX_FMT_NONE;
+  AVPixelFormat dst_format_ = AV_PIX_FMT_NONE;
+};
+
+#endif // SLICE_SCALER_H
@@ -0,0 +1,68 @@
+#ifndef V4L2_SOURCE_H
+#define V4L2_SOURCE_H
+
+#include <string>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+// 直接使用 V4L2 mmap 缓冲区的摄像头采集源，不经过 libavdevice。
+// 采集到的帧以零拷贝方式包装成 AVPacket：packet 引用驱动的 mmap 缓冲区，
+// 最后一个引用释放时缓冲区自动重新入队（VIDIOC_QBUF）。
+// 裸格式（YUYV/NV12 等）经 rawvideo 解码后得到的 AVFrame 同样直接引用该缓冲区
+class V4L2Source {
+public:
+  explicit V4L2Source(bool debug_enabled = false);
+  ~V4L2Source();
+
+  V4L2Source(const V4L2Source &) = delete;
+  V4L2Source &operator=(const V4L2Source &) = delete;
+
+  // format 与 libavdevice v4l2 的 input_format 取值一致：
+  // mjpeg、yuyv422、nv12、yuv420p、h264。设备或格式不支持时返回 false
+  bool open(const std::string &device, int width, int height, int fps,
+            const std::string &format);
+  void close();
+  bool is_open() const { return pool_ != nullptr; }
+
+  // 空闲时停止/恢复采集（STREAMOFF/STREAMON），设备和 mmap 缓冲区保持打开。
+  // 停止时驱动中积压的帧全部丢弃，恢复后只输出新采集的帧
+  bool stop_streaming();
+  bool start_streaming();
+
+  // 等待最多 timeout_ms 毫秒并取出一帧。成功返回 0，超时返回 AVERROR(EAGAIN)
+  int read_packet(AVPacket *packet, int timeout_ms);
+
+  // 编码类摄像头（input_format=h264）的码率和关键帧控制，
+  // 驱动不支持对应控制项时返回 false。主线 uvcvideo 不提供这两个控制项
+  bool set_bitrate(int bit_rate);
+  bool request_keyframe();
+  // 打开设备时通过 VIDIOC_QUERYCTRL 检查的控制项是否可用
+  bool can_set_bitrate() const { return has_bitrate_control_; }
+  bool can_force_keyframe() const { return has_keyframe_control_; }
+
+  // 驱动实际协商出的参数，用于创建解码器
+  const AVCodecParameters *codec_parameters() const { return codecpar_; }
+  AVRational frame_rate() const { return frame_rate_; }
+
+private:
+  struct BufferPool;
+
+  static void release_buffer(void *opaque, uint8_t *data);
+  bool set_control(uint32_t id, int32_t value, const char *name);
+  bool query_control(uint32_t id) const;
+
+  bool debug_enabled_;
+  BufferPool *pool_ = nullptr;
+  AVCodecParameters *codecpar_ = nullptr;
+  AVRational frame_rate_{0, 1};
+  // 压缩格式的包需要尾部填充，缓冲区剩余空间不足时只能拷贝
+  bool needs_padding_ = false;
+  bool intra_only_ = true;
+  bool is_h264_ = false;
+  bool has_bitrate_control_ = false;
+  bool has_keyframe_control_ = false;
+};
+
+#endif // V4L2_SOURCE_H
@@ -2,8 +2,13 @@
 #define VIDEO_CAPTURER_H
 
 #include "capture.h"
+#include "frame_pacer.h"
+#include "h264_nal.h"
+#include "slice_scaler.h"
+#include "v4l2_source.h"
 #include <memory>
 #include <string>
+#include <vector>
 
 // Forward declarations
 class Encoder;
@@ -31,39 +36,221 @@ public:
   ~VideoCapturer();
   bool start() override;
   void stop() override;
-  void reconfigure(const std::string &resolution, int fps, int bitrate, const std::string &format);
-  void set_video_codec(const std::string &codec); // 设置视频编码器类型 (h264 or h265)
+  // 最后一个观看者离开时调用：进入空闲模式，见 wait_while_idle
+  void pause_capture() override;
+  void resume_capture() override;
+  void reconfigure(const std::string &resolution, int fps, int bitrate, const std::string &format,
+                   int rotation, bool mirror);
+  void set_video_codec(const std::string &codec); // 设置视频编码器类型，见 encoder_factory.h
   std::string get_video_codec() const { return video_codec_; } // 获取当前视频编码器类型
+  // 编码输出分辨率（WIDTHxHEIGHT），为空时与采集分辨率相同
+  void set_output_resolution(const std::string &resolution);
+  // 顺时针旋转角度（0/90/180/270）及旋转后是否水平镜像，
+  // 运行中通过 reconfigure 修改
+  void set_rotation(int rotation, bool mirror);
+  int get_rotation() const { return rotation_; }
+  bool get_mirror() const { return mirror_; }
+  // 缩放使用的条带数（并行线程数），0 为自动，1 为单线程
+  void set_scale_threads(int threads);
+  // 摄像头 H.264 直通：input_format 固定为 h264，包直接进入发送队列
+  void set_camera_passthrough(bool enabled);
+  // 编码器使用周期性帧内刷新代替周期性 IDR；idr_on_join 为 true 时新观看者加入
+  // 仍立即请求 IDR（浏览器的 H.264 解码只能从 IDR 开始），否则新观看者等待
+  // 下一轮刷新开始。需在 start() 之前调用
+  void set_intra_refresh(bool enabled, bool idr_on_join);
+  // 编码器 slice 的最大字节数，0 表示不限制。需在 start() 之前调用
+  void set_max_slice_size(int bytes);
+  // 解码/编码线程数，0 表示按 CPU 核数和分辨率自动选择；默认只使用 slice 线程，
+  // frame_threads 为 true 时改用帧级线程，以延迟换吞吐。需在 start() 之前调用
+  void set_codec_threads(int decoder_threads, int encoder_threads,
+                         bool frame_threads);
+  // 无观看者后保持热备的秒数，超过后停止摄像头采集；0 表示立即停止
+  void set_idle_grace_period(int seconds);
+  // 请求关键帧：有编码器时由编码器输出，直通模式下通过摄像头控制项请求。
+  // 可由任意线程调用（如 RTCP PLI 回调）
+  void request_keyframe();
 
 private:
   void capture_loop() override;
-  void decode_loop() override;
-  void encode_loop() override;
-  void send_loop() override;
+  bool decode_step() override;
+  bool encode_step() override;
+  bool send_step() override;
+
+  // 打开视频输入：优先使用原生 V4L2 采集，失败时回退到 libavdevice
+  bool open_camera_input();
+  // probe 为 false 时不调用 avformat_find_stream_info，直接使用打开时已知的参数
+  bool find_video_stream(bool probe = true);
+  // libavdevice 打开后参数是否已经完整，完整时无需读帧探测
+  bool camera_parameters_known() const;
+  const AVCodecParameters *input_codec_parameters() const;
+  // 按编码器输出尺寸打开输入解码器，MJPEG 输入会尽量直接解码为缩小的帧
+  bool open_decoder(int out_width, int out_height);
+  static int choose_decode_lowres(const AVCodec *codec,
+                                  const AVCodecParameters *codec_params,
+                                  int out_width, int out_height);
+  void output_size(int &width, int &height) const;
+  AVRational input_frame_rate() const;
+  int read_input_packet(AVPacket *packet);
+  // 输入时间戳（V4L2 为驱动采集时间）换算为微秒，缺失时使用当前时间
+  int64_t input_time_us(int64_t pts) const;
+  // 根据采集/编码帧率更新降帧目标。采集线程和 reconfigure 都会调用，
+  // 调用方需持有 config_mutex_
+  void update_pacing();
+  // 判断该时间戳的帧是否保留：帧内编码输入在采集线程丢包，帧间编码输入在解码后丢帧
+  bool pace_frame(int64_t timestamp_us);
+  // 能否强制输出关键帧：转发网络流或摄像头没有 FORCE_KEY_FRAME 控制项时不能
+  bool can_force_keyframe();
+  void reconfigure_passthrough(const std::string &resolution, int fps,
+                               int bitrate);
+
+  // 没有观看者时的等待：宽限期内继续读取并丢弃摄像头帧（热备，恢复时没有积压的旧帧），
+  // 超过宽限期后停止摄像头采集，有观看者后重新开流再返回。网络流输入只等待
+  void wait_while_idle(AVPacket *packet);
+  void power_down_input();
+  bool power_up_input();
+
+  // 双缓冲重建输出链路：新的编码器和缩放器在运行中的链路旁边建好，解码任务在帧边界
+  // 切换缩放输出，编码任务遇到第一帧新版本的帧时切换编码器（新编码器首帧为 IDR），
+  // 旧资源在线程池上异步释放。采集设备和解码器保持不变
+  struct OutputChain {
+    std::unique_ptr<Encoder> encoder;
+    SliceScaler scaler;
+    int rotation = 0;
+    bool mirror = false;
+    uint32_t generation = 0;
+    int64_t requested_us = 0; // 开始重建的时间，用于统计切换耗时
+  };
+  std::unique_ptr<Encoder> make_encoder() const;
+  // 非法角度（不是 0/90/180/270）时打印警告并返回当前角度
+  int checked_rotation(int rotation) const;
+  // width/height 为旋转前的输出尺寸，rotation 需已经过 checked_rotation 校验
+  bool rebuild_output_chain(int width, int height, int fps, int bitrate,
+                            int rotation, bool mirror);
+  void switch_scale_output();
+  bool switch_encoder(uint32_t generation);
+  void discard_pending_output();
+  static void release_output_chain(std::unique_ptr<OutputChain> chain);
+
+  // 启动耗时统计：start/reconfigure 开始计时，各阶段首次到达时输出一次耗时
+  enum class StartupPhase { DeviceOpen, FirstPacket, FirstEncodedFrame };
+  void begin_startup_timing(const char *reason);
+  void log_startup_phase(StartupPhase phase);
+
+  void decode_packet(TimedPacket input);
+  // 将解码后的帧缩放为编码器输入格式，失败时返回空；
+  // 布局已与编码器输入一致时返回引用解码器缓冲区的帧
+  AVFramePtr scale_frame(AVFrame *frame);
+  bool frame_matches_encoder(const AVFrame *frame) const;
+  // 缩放/格式转换到旋转前的编码器布局
+  bool convert_for_encoder(AVFrame *frame, AVFrame *target);
+  AVFrame *rotate_scratch_frame();
+  // 根据编码器参数和旋转角度更新输出尺寸，调用方需持有 frame_pool_mutex_ 或已暂停流水线
+  void update_output_geometry(const Encoder &encoder);
+  bool input_full_range() const;
+  // 按当前输入是否为帧内编码设置解码队列的溢出策略和降帧位置，需在采集暂停时调用
+  void update_input_policy();
+  bool create_scaler(int width, int height, AVPixelFormat format);
+  void record_scale_time(int64_t elapsed_us);
+  void log_queue_stats(const std::string &label) override;
+  // 编码一帧并将结果推入发送队列，编码任务和 fused 模式共用
+  void encode_and_queue(TimedFrame input);
+
+  // GOP 感知的压缩包入队：队列满时丢弃该包，并一直丢弃到下一个关键帧，
+  // 避免后续依赖它的帧花屏；request_idr 为 true 时同时请求编码器立即输出 IDR。
+  // 返回该包是否入队
+  bool push_gop_aware(SafeQueue<TimedPacket> &queue, TimedPacket item,
+                      std::atomic<bool> &waiting_for_keyframe,
+                      bool request_idr);
 
   // Frame pool for scaled YUV420P frames to reduce frequent alloc/free
-  AVFrame *acquire_scaled_frame();
-  void release_scaled_frame(AVFrame *frame);
+  AVFramePtr acquire_scaled_frame();
+  void release_scaled_frame(AVFramePtr frame);
   void clear_frame_pool();
 
   bool is_udp_stream_ = false;  // 是否为UDP流模式
+  bool camera_passthrough_ = false; // 是否为摄像头 H.264 直通模式
   std::string device_;
   std::string resolution_;
+  std::string output_resolution_; // 编码输出分辨率，为空时与 resolution_ 相同
   int framerate_;
   std::string video_format_;
-  std::string video_codec_ = "h264"; // 视频编码器类型: h264 or h265
+  std::string video_codec_ = "h264"; // 视频编码器类型: h264、h265、vp8、vp9 或 av1
   AVFormatContext *format_context_ = nullptr;
+  std::unique_ptr<V4L2Source> v4l2_source_; // 原生 V4L2 采集，为空时使用 format_context_
+  H264ParameterSets parameter_sets_; // 转发模式下缓存的 SPS/PPS，仅采集线程访问
+  // 其他线程请求丢弃缓存的 SPS/PPS，由采集线程在下一次 process 前清空
+  std::atomic<bool> reset_parameter_sets_{false};
   AVCodecContext *codec_context_ = nullptr;
-  SwsContext *sws_context_ = nullptr;
+  SliceScaler scaler_;
+  int scale_threads_ = 0;
+  // 缩放耗时统计，随队列统计一起输出
+  std::atomic<uint64_t> scale_count_{0};
+  std::atomic<uint64_t> scale_total_us_{0};
+  std::atomic<uint64_t> scale_max_us_{0};
+  // 编码统计（随队列统计输出），用于比较不同编码器的 CPU 耗时和实际码率
+  std::atomic<uint64_t> encode_count_{0};
+  std::atomic<uint64_t> encode_total_us_{0};
+  std::atomic<uint64_t> encode_bytes_{0};
+  std::atomic<int> scale_slices_{0};
   int video_stream_index_ = -1;
 
-  // Cached encoder output parameters for sws_context_ and frame pool
+  // 没有观看者，初始为 true，直到第一个观看者触发 resume_capture
+  std::atomic<bool> idle_{true};
+  bool input_powered_down_ = false; // 只由采集线程和持有 config_mutex_ 的操作访问
+  int idle_grace_seconds_ = 10;
+  bool intra_refresh_ = false;
+  bool idr_on_join_ = true;
+  int max_slice_size_ = 0;
+  int decoder_threads_ = 0;
+  int encoder_threads_ = 0;
+  bool frame_threads_ = false;
+
+  std::mutex output_chain_mutex_;
+  std::unique_ptr<OutputChain> pending_output_;  // 已建好，等待解码任务切换
+  std::unique_ptr<OutputChain> pending_encoder_; // 缩放已切换，等待编码任务切换
+  std::atomic<bool> output_switch_pending_{false};
+  uint32_t output_chain_counter_ = 0; // 只在持有 config_mutex_ 时修改
+  uint32_t output_generation_ = 0;    // 解码阶段当前的链路版本
+  uint32_t encoder_generation_ = 0;   // 编码阶段当前编码器的链路版本
+  // 保护 encoder_ 指针的切换；编码任务自身使用 encoder_ 时不需要加锁
+  std::mutex encoder_mutex_;
+  bool encode_full_range_ = false; // 解码阶段使用的编码器 full range 设置
+
+  std::atomic<int64_t> startup_begin_us_{0};
+  std::atomic<const char *> startup_reason_{"start"};
+  std::atomic<unsigned> startup_logged_phases_{0};
+
+  // 输入是否为帧内编码（如 MJPEG/rawvideo），帧内编码的包可以任意丢弃
+  std::atomic<bool> input_intra_only_{true};
+  // 编码帧率低于采集帧率时按时间戳降帧，0 表示不降帧
+  std::atomic<int> pacing_fps_{0};
+  // 编码输出帧率，码率/帧率原地调整后可能低于采集帧率 framerate_
+  std::atomic<int> encode_fps_{0};
+  FramePacer frame_pacer_; // 只由执行降帧的阶段访问
+  // 溢出或暂停后等待关键帧的状态
+  std::atomic<bool> decode_wait_keyframe_{false};
+  std::atomic<bool> send_wait_keyframe_{false};
+
+  // 各阶段任务在多次执行之间保留的状态，同一阶段的任务不会并发执行
+  AVFramePtr decoded_frame_;
+  AVPacketPtr encode_packet_;
+  std::vector<TimedPacket> send_batch_;
+  bool send_dropping_until_keyframe_ = false;
+
+  // Cached encoder output parameters for scaler_ and frame pool
   int encoder_out_width_ = 0;
   int encoder_out_height_ = 0;
   AVPixelFormat encoder_out_pix_fmt_ = AV_PIX_FMT_YUV420P;
+  // 旋转前的缩放输出尺寸，旋转 90/270 度时与编码器宽高互换
+  int scale_out_width_ = 0;
+  int scale_out_height_ = 0;
+
+  int rotation_ = 0;
+  bool mirror_ = false;
+  AVFramePtr rotate_scratch_; // 需要旋转时的转换中间帧，仅解码阶段访问
 
   // A small pool of reusable scaled frames
-  std::vector<AVFrame *> scaled_frame_pool_;
+  std::vector<AVFramePtr> scaled_frame_pool_;
   std::mutex frame_pool_mutex_;
 
   std::shared_ptr<rtc::Track> track_;
@@ -0,0 +1,39 @@
+#ifndef VPX_ENCODER_H
+#define VPX_ENCODER_H
+
+#include "encoder.h"
+#include <atomic>
+#include <utility>
+
+// libvpx 实时编码，VP8 和 VP9 共用，选项基本一致
+class VpxEncoder : public Encoder {
+public:
+  enum class Codec { VP8, VP9 };
+
+  VpxEncoder(Codec codec, bool debug_enabled = false);
+  ~VpxEncoder();
+
+  bool open_encoder(int width, int height, int fps, int64_t bit_rate) override;
+  void close_encoder() override;
+
+  AVCodecContext *get_context() const override { return encoder_context_; }
+
+  bool encode_frame(AVFrame *frame, AVPacket *packet) override;
+  void request_keyframe() override { keyframe_requested_ = true; }
+
+protected:
+  AVCodecContext *exchange_context(AVCodecContext *context) override {
+    std::swap(context, encoder_context_);
+    return context;
+  }
+
+private:
+  const char *name() const { return codec_type_ == Codec::VP9 ? "VP9" : "VP8"; }
+
+  Codec codec_type_;
+  bool debug_enabled_;
+  AVCodecContext *encoder_context_;
+  const AVCodec *codec_;
+  std::atomic<bool> keyframe_requested_{false};
+};
+#endif // VPX_ENCODER_H
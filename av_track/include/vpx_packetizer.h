@@ -0,0 +1,27 @@
+#ifndef VPX_PACKETIZER_H
+#define VPX_PACKETIZER_H
+
+#include "rtc/rtc.hpp"
+#include <cstdint>
+
+// VP8（RFC 7741）/VP9（RFC 9628）RTP 打包器，libdatachannel 只提供 H.264/H.265/AV1。
+// 每帧按 max_fragment_size 切分，每个包带载荷描述符和 15 位 PictureID；
+// VP9 使用非灵活模式、单层，不带 SS 数据
+class VpxRtpPacketizer final : public rtc::RtpPacketizer {
+public:
+  enum class Codec { VP8, VP9 };
+
+  VpxRtpPacketizer(Codec codec,
+                   std::shared_ptr<rtc::RtpPacketizationConfig> rtp_config,
+                   uint16_t max_fragment_size);
+
+protected:
+  std::vector<rtc::binary> fragment(rtc::binary data) override;
+
+private:
+  Codec codec_;
+  uint16_t max_fragment_size_;
+  uint16_t picture_id_ = 0; // 只由发送线程访问
+};
+
+#endif // VPX_PACKETIZER_H
@@ -0,0 +1,92 @@
+#!/bin/bash
+# 对比默认多线程流水线与 fused 流水线（-L）的 CPU 占用、上下文切换和端到端丢帧
+# 用法：./pipeline_bench.sh [秒数]，运行期间需要有一个观看端连接，否则采集不会开始
+TARGET_HOST="fy403.cn" # 信令服务器地址
+TARGET_PORT=8000 # 信令服务器端口
+VIDEO_DEVICE="/dev/video1" # 摄像头设备
+CLIENT_ID="bench_cam" # 客户端ID
+RESOLUTION="640x480" # 画面分辨率
+INPUT_FORMAT="mjpeg" # mjpeg, yuyv422
+FPS=30 # 画面帧率
+VIDEO_CODEC="h264" # 视频编码器: h264 或 h265
+DURATION=${1:-60} # 每种模式运行时长（秒）
+STATS_INTERVAL=10 # 队列统计输出间隔（秒）
+BUILD_DIR="./build"
+
+# 读取进程累计的 CPU 时间（jiffies）：/proc/$pid/stat 的 utime+stime 包含
+# 已退出线程的时间，按线程求和会漏掉采样间隔内退出的线程
+sample_proc() {
+    local stat=($(cut -d')' -f2 /proc/$1/stat))
+    echo $((stat[11] + stat[12]))
+}
+
+# 各线程的 CPU 时间和上下文切换次数，仅作为分线程明细（只包含仍存活的线程）
+# 输出：每行 "tid 线程名 jiffies voluntary nonvoluntary"
+sample_tasks() {
+    local pid=$1
+    for task in /proc/$pid/task/*; do
+        # 线程可能在遍历过程中退出
+        [ -r $task/stat ] || continue
+        local comm=$(cat $task/comm 2>/dev/null)
+        local stat=($(cut -d')' -f2 $task/stat 2>/dev/null))
+        local vcs=$(awk '/^voluntary_ctxt_switches/ {print $2}' $task/status 2>/dev/null)
+        local ivcs=$(awk '/^nonvoluntary_ctxt_switches/ {print $2}' $task/status 2>/dev/null)
+        echo "${task##*/} ${comm// /_} $((stat[11] + stat[12])) ${vcs:-0} ${ivcs:-0}"
+    done
+}
+
+run_mode() {
+    local name=$1
+    shift
+    local log="pipeline_bench_${name}.log"
+
+    echo "$(date): Running $name pipeline for ${DURATION}s..."
+    $BUILD_DIR/webrtc_publisher \
+    -w $TARGET_HOST -x $TARGET_PORT \
+    -R $RESOLUTION -F $FPS \
+    -V $INPUT_FORMAT \
+    -E $VIDEO_CODEC \
+    -q $STATS_INTERVAL \
+    -c $CLIENT_ID -i $VIDEO_DEVICE "$@" > $log 2>&1 &
+    local pid=$!
+
+    # 等待启动和观看端连接后再开始计时
+    sleep 5
+    local before=$(sample_proc $pid)
+    sample_tasks $pid > "$log.tasks_before"
+    sleep $DURATION
+    local after=$(sample_proc $pid)
+    sample_tasks $pid > "$log.tasks_after"
+    local threads=$(ls /proc/$pid/task | wc -l)
+
+    kill -INT $pid
+    wait $pid
+
+    local hz=$(getconf CLK_TCK)
+    local cpu=$(awk -v j=$((after - before)) -v hz=$hz -v d=$DURATION \
+        'BEGIN { printf "%.1f", j * 100.0 / hz / d }')
+    echo "$name: threads=$threads cpu=${cpu}%"
+
+    # 分线程明细：按线程名汇总两次采样之间的 CPU 占用和上下文切换，
+    # 采样间隔内退出的线程不在其中，合计可能小于上面的进程总量
+    echo "$name: per-thread breakdown (live threads only):"
+    awk -v hz=$hz -v d=$DURATION '
+        NR == FNR { j[$1] = $3; v[$1] = $4; iv[$1] = $5; next }
+        {
+            cpu[$2] += $3 - j[$1]
+            vcs[$2] += $4 - v[$1]
+            ivcs[$2] += $5 - iv[$1]
+        }
+        END {
+            for (c in cpu) {
+                printf "  %-16s cpu=%.1f%% voluntary_ctxt_switches=%d nonvoluntary_ctxt_switches=%d\n",
+                    c, cpu[c] * 100.0 / hz / d, vcs[c], ivcs[c]
+            }
+        }' "$log.tasks_before" "$log.tasks_after" | sort -t= -k2 -rn
+    rm -f "$log.tasks_before" "$log.tasks_after"
+    echo "$name: last queue stats ($log):"
+    grep -E "queue|stale" $log | tail -n 6
+}
+
+run_mode threaded
+run_mode fused -L
@@ -32,6 +32,10 @@ AudioCapturer::AudioCapturer(const AudioDeviceParams &params,
     : Capture(debug_enabled, decode_queue_capacity, encode_queue_capacity, send_queue_capacity),
       audio_params_(params) {
   avdevice_register_all();
+  // 音频优先保证连续性：队列满时只丢弃新到的数据，不再清空所有队列
+  decode_queue_.set_overflow_policy(OverflowPolicy::DropNewest);
+  encode_queue_.set_overflow_policy(OverflowPolicy::DropNewest);
+  send_queue_.set_overflow_policy(OverflowPolicy::DropNewest);
   // Initialize Opus encoder instead of AAC
   encoder_ = std::make_unique<OpusEncoder>(debug_enabled);
 }
@@ -124,30 +128,34 @@ bool AudioCapturer::start() {
   }
 
   is_running_ = true;
-  // 等待 track_callback_ 设置后再启动采集线程
-  capture_thread_ = std::thread(&AudioCapturer::capture_loop, this);
-  decode_thread_ = std::thread(&AudioCapturer::decode_loop, this);
-  encode_thread_ = std::thread(&AudioCapturer::encode_loop, this);
-  send_thread_ = std::thread(&AudioCapturer::send_loop, this);
-
-  // 如果CPU数量大于等于4，则绑定线程到不同的CPU
-  int cpu_count = get_cpu_count();
-  if (cpu_count >= 4) {
-    std::cout << "Detected " << cpu_count << " CPUs, binding threads to different CPUs" << std::endl;
-    bind_thread_to_cpu(capture_thread_, 0); // 采集线程绑定到CPU 0
-    bind_thread_to_cpu(decode_thread_, 3);  // 解码线程绑定到CPU 3
-    bind_thread_to_cpu(encode_thread_, 1);  // 编码线程绑定到CPU 1
-    bind_thread_to_cpu(send_thread_, 2);    // 发送线程绑定到CPU 2
+  decoded_frame_ = make_av_frame();
+  encode_packet_ = make_av_packet();
+
+  // 解码/编码/发送作为高优先级任务运行在共享线程池上，与视频同时工作时先执行；
+  // fused 模式下编码在解码任务内完成
+  if (fused_pipeline_) {
+    start_stages(TaskPriority::High,
+                 {PipelineStage::Decode, PipelineStage::Send});
   } else {
-    std::cout << "CPU count: " << cpu_count << ", skipping CPU binding" << std::endl;
+    start_stages(TaskPriority::High, {PipelineStage::Decode,
+                                      PipelineStage::Encode,
+                                      PipelineStage::Send});
   }
 
+  // 等待 track_callback_ 设置后再启动采集线程
+  capture_thread_ = std::thread(&AudioCapturer::capture_loop, this);
+  start_queue_stats("Audio");
+
   std::cout << "Audio capture started successfully" << std::endl;
   return true;
 }
 
 void AudioCapturer::stop() {
   Capture::stop();
+  decoded_frame_.reset();
+  encode_packet_.reset();
+  decoded_batch_.clear();
+  send_batch_.clear();
 
   if (codec_context_) {
     avcodec_free_context(&codec_context_);
@@ -161,7 +169,7 @@ void AudioCapturer::stop() {
 }
 
 void AudioCapturer::capture_loop() {
-  AVPacket *packet = av_packet_alloc();
+  AVPacketPtr packet = make_av_packet();
   // 等待 track_callbacks_ 被设置 (多peer支持)
   {
     std::unique_lock<std::mutex> lock(callback_mutex_);
@@ -170,7 +178,6 @@ void AudioCapturer::capture_loop() {
   }
 
   if (!is_running_) {
-    av_packet_free(&packet);
     return;
   }
   std::cout << "Capture thread started" << std::endl;
@@ -181,7 +188,7 @@ void AudioCapturer::capture_loop() {
       continue;
     }
     // 读取数据包
-    int ret = av_read_frame(format_context_, packet);
+    int ret = av_read_frame(format_context_, packet.get());
     if (ret < 0) {
       if (ret == AVERROR(EAGAIN)) {
         std::this_thread::sleep_for(
@@ -204,51 +211,50 @@ void AudioCapturer::capture_loop() {
       continue;
     }
 
-    if (packet->stream_index == audio_stream_index_) {
-      // 将数据包放入解码队列
-      AVPacket *clone_packet = av_packet_alloc();
-      av_packet_ref(clone_packet, packet);
-      
-      // 使用非阻塞方式推入队列
-      if (!decode_queue_.try_push(clone_packet)) {
-        if (debug_enabled_) {
-          std::cout << "Audio Decode queue full, dropping packet" << std::endl;
-          std::cout << "Audio Decode queue Len: " << decode_queue_.size()
-                    << ", Capacity: " << decode_queue_.capacity()
-                    << std::endl;
-        }
-        av_packet_free(&clone_packet);
-        decode_queue_.clear();
-        encode_queue_.clear();
-        send_queue_.clear();
-      }
+    if (packet->stream_index != audio_stream_index_) {
+      av_packet_unref(packet.get());
+      continue;
     }
-    av_packet_unref(packet);
-  }
 
-  av_packet_free(&packet);
+    // 将数据包的所有权直接移入解码队列，队列满时由队列丢弃该包
+    if (!decode_queue_.try_push({std::move(packet), steady_now_us()}) &&
+        debug_enabled_) {
+      std::cout << "Audio Decode queue full, dropping packet" << std::endl;
+      std::cout << "Audio Decode queue Len: " << decode_queue_.size()
+                << ", Capacity: " << decode_queue_.capacity()
+                << std::endl;
+    }
+    wake_stage(PipelineStage::Decode);
+    packet = make_av_packet();
+  }
 }
 
-void AudioCapturer::decode_loop() {
-  AVPacket *packet = nullptr;
-  AVFrame *frame = av_frame_alloc();
+bool AudioCapturer::decode_step() {
+  TimedPacket input;
   static auto start_time = std::chrono::steady_clock::now();
-  std::string wav_filename = "captured_audio.wav";
-  while (is_running_) {
-    decode_queue_.wait_pop(packet);
-    
-    if (!packet)
+  const std::string wav_filename = "captured_audio.wav";
+  std::vector<TimedFrame> &decoded_frames = decoded_batch_;
+
+  for (size_t n = 0; n < kStageBatchSize && is_running_; ++n) {
+    if (!decode_queue_.try_pop(input)) {
+      break;
+    }
+
+    // 已超过解码阶段预算的包直接丢弃
+    if (is_stale(PipelineStage::Decode, input.capture_us)) {
+      input.packet.reset();
       continue;
+    }
 
-    int ret = avcodec_send_packet(codec_context_, packet);
+    AVPacketPtr &packet = input.packet;
+    int ret = avcodec_send_packet(codec_context_, packet.get());
     if (ret < 0) {
-      av_packet_free(&packet);
       continue;
     }
 
     while (ret >= 0) {
       // 解码数据包
-      ret = avcodec_receive_frame(codec_context_, frame);
+      ret = avcodec_receive_frame(codec_context_, decoded_frame_.get());
       if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
         break;
       } else if (ret < 0) {
@@ -256,93 +262,114 @@ void AudioCapturer::decode_loop() {
                   << std::endl;
         break;
       }
-      
+
       if (debug_enabled_) {
         auto current_time = std::chrono::steady_clock::now();
         if (current_time - start_time <= std::chrono::seconds(10)) {
-          DebugUtils::save_raw_audio_packet(packet, wav_filename);
+          DebugUtils::save_raw_audio_packet(packet.get(), wav_filename);
         } else {
           DebugUtils::finalize_raw_audio_file();
         }
       }
 
-      // 使用非阻塞方式推入队列
-      if (!encode_queue_.try_push(frame)) {
-        if (debug_enabled_) {
-          std::cout << "Audio Encode queue full, dropping audio frame"
-                    << std::endl;
-          std::cout << "Audio Encode queue Len: " << encode_queue_.size()
-                    << ", Capacity: " << encode_queue_.capacity()
-                    << std::endl;
-        }
-        av_frame_unref(frame);
-        encode_queue_.clear();
-        send_queue_.clear();
+      if (fused_pipeline_) {
+        // 直接在本任务内编码，省去一次队列交接和任务调度
+        encode_and_queue({std::move(decoded_frame_), input.capture_us});
       } else {
-        frame = av_frame_alloc();
+        decoded_frames.push_back({std::move(decoded_frame_), input.capture_us});
       }
+      decoded_frame_ = make_av_frame();
     }
-    av_packet_free(&packet);
+    packet.reset();
   }
-  av_frame_free(&frame);
-}
-
-void AudioCapturer::encode_loop() {
-  AVPacket *packet = av_packet_alloc();
-  AVFrame *frame = nullptr;
 
-  while (is_running_) {
-    encode_queue_.wait_pop(frame);
-    if (!frame)
-      continue;
-
-    if (!is_running_) {
-      av_packet_free(&packet);
-      break;
+  // 整批推入队列，队列满时由队列释放多余的帧
+  size_t decoded = decoded_frames.size();
+  if (decoded > 0) {
+    if (encode_queue_.try_push_bulk(decoded_frames) < decoded &&
+        debug_enabled_) {
+      std::cout << "Audio Encode queue full, dropping audio frame"
+                << std::endl;
+      std::cout << "Audio Encode queue Len: " << encode_queue_.size()
+                << ", Capacity: " << encode_queue_.capacity()
+                << std::endl;
     }
+    decoded_frames.clear();
+    wake_stage(PipelineStage::Encode);
+  }
+  return is_running_ && !decode_queue_.empty();
+}
 
-    bool encoded = encoder_->encode_frame(frame, packet);
-    if (encoded) {
-        send_queue_.wait_push(packet);
-      packet = av_packet_alloc();
+bool AudioCapturer::encode_step() {
+  TimedFrame input;
+  for (size_t n = 0; n < kStageBatchSize && is_running_; ++n) {
+    if (!encode_queue_.try_pop(input)) {
+      return false;
     }
-    av_frame_free(&frame);
+    encode_and_queue(std::move(input));
   }
-  av_packet_free(&packet);
+  return is_running_ && !encode_queue_.empty();
 }
 
-void AudioCapturer::send_loop() {
-  AVPacket *packet = nullptr;
-  while (is_running_) {
-    send_queue_.wait_pop(packet);
-    if (!packet)
-      continue;
+void AudioCapturer::encode_and_queue(TimedFrame input) {
+  // 已超过编码阶段预算的帧不再编码
+  if (is_stale(PipelineStage::Encode, input.capture_us)) {
+    return;
+  }
 
-    if (!is_running_) {
-      av_packet_free(&packet);
-      break;
-    }
+  bool encoded =
+      encoder_->encode_frame(input.frame.get(), encode_packet_.get());
+  if (encoded) {
+    // 任务中不能阻塞等待，发送队列满时由队列丢弃新包
+    send_queue_.try_push({std::move(encode_packet_), input.capture_us});
+    wake_stage(PipelineStage::Send);
+    encode_packet_ = make_av_packet();
+  }
+}
 
-    // Send data to all registered callbacks (multiple peer support)
-    auto data = reinterpret_cast<const std::byte *>(packet->data);
-    size_t data_size = packet->size;
+bool AudioCapturer::send_step() {
+  // xrun 之后的追帧会一次积压多个包，整批取出并只加一次 callbacks 锁
+  constexpr size_t kSendBatchSize = 32;
+  std::vector<TimedPacket> &packets = send_batch_;
+
+  packets.clear();
+  if (!is_running_ || send_queue_.try_pop_bulk(packets, kSendBatchSize) == 0) {
+    return false;
+  }
+
+  // Opus 包之间相互独立，超过发送阶段预算的包可以单独丢弃
+  packets.erase(std::remove_if(packets.begin(), packets.end(),
+                               [this](const TimedPacket &item) {
+                                 return is_stale(PipelineStage::Send,
+                                                 item.capture_us);
+                               }),
+                packets.end());
 
+  if (!packets.empty()) {
     // 使用互斥锁保护callbacks map的访问
     std::lock_guard<std::mutex> lock(callbacks_mutex_);
 
-    for (const auto &pair : track_callbacks_) {
-      if (pair.second) {
-        pair.second(data, data_size);
+    // Send data to all registered callbacks (multiple peer support)
+    for (const auto &item : packets) {
+      const AVPacketPtr &packet = item.packet;
+      auto data = reinterpret_cast<const std::byte *>(packet->data);
+      size_t data_size = packet->size;
+      for (const auto &pair : track_callbacks_) {
+        if (pair.second) {
+          pair.second(data, data_size);
+        }
       }
     }
 
     if (debug_enabled_ && !track_callbacks_.empty()) {
-      std::cout << "Send encoded packet: size=" << packet->size
+      std::cout << "Send encoded packets: count=" << packets.size()
                 << ", Send queue Len: " << send_queue_.size()
                 << ", Callbacks: " << track_callbacks_.size() << std::endl;
     } else if (debug_enabled_) {
       std::cout << "Drop packet! No callback set." << std::endl;
     }
-    av_packet_free(&packet);
   }
+
+  packets.clear();
+  return is_running_ && !send_queue_.empty();
 }
\ No newline at end of file
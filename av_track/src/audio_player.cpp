@@ -11,18 +11,9 @@ AudioPlayer::AudioPlayer(const AudioPlayerDeviceParams &params)
     : params_(params), opus_decoder_(std::make_unique<OpusDecoder>()),
       decode_queue_(50),         // 减少队列大小以降低延迟
       audio_sample_queue_(100) { // 减少队列大小以降低延迟
-
-  decode_queue_.set_deleter([](AVPacket *&packet) {
-    if (packet) {
-      av_packet_free(&packet);
-    }
-  });
-
-  audio_sample_queue_.set_deleter([](AVFrame *&frame) {
-    if (frame) {
-      av_frame_free(&frame);
-    }
-  });
+  // 队列满时丢弃新数据以降低延迟
+  decode_queue_.set_overflow_policy(OverflowPolicy::DropNewest);
+  audio_sample_queue_.set_overflow_policy(OverflowPolicy::DropNewest);
   setVolume(params_.volume);
 }
 
@@ -46,10 +37,27 @@ void AudioPlayer::start() {
   //    return;
   //  }
 
+  decoded_frame_ = make_av_frame();
+  resampled_frame_ = make_av_frame();
+  if (!decoded_frame_ || !resampled_frame_) {
+    std::cerr << "Failed to allocate frames" << std::endl;
+    SDL_Quit();
+    return;
+  }
+  decoder_initialized_ = false;
+  sdl_initialized_ = false;
+  sdl_failed_ = false;
+  resampler_initialized_ = false;
+
   running_ = true;
 
-  // 启动解码线程
-  decode_thread_ = std::thread(&AudioPlayer::decodeThread, this);
+  // 解码作为高优先级任务运行在共享线程池上，收到数据包时唤醒
+  {
+    std::lock_guard<std::mutex> lock(receive_mutex_);
+    decode_task_ = std::make_unique<SerialTask>(
+        Executor::shared(), TaskPriority::High,
+        [this] { return decodeStep(); });
+  }
 
   std::cout << "Audio player started successfully" << std::endl;
 }
@@ -61,13 +69,18 @@ void AudioPlayer::stop() {
   std::cout << "Stopping audio player..." << std::endl;
   running_ = false;
 
-  // 清空队列唤醒等待的线程
+  // 等待正在执行的解码任务结束
+  {
+    std::lock_guard<std::mutex> lock(receive_mutex_);
+    if (decode_task_) {
+      decode_task_->close();
+      decode_task_.reset();
+    }
+  }
+
   decode_queue_.clear();
   audio_sample_queue_.clear();
-
-  if (decode_thread_.joinable()) {
-    decode_thread_.join();
-  }
+  DebugUtils::finalize_raw_audio_frame_file2();
 
   cleanup();
   SDL_Quit();
@@ -176,22 +189,19 @@ void AudioPlayer::receiveAudioData(const rtc::binary &data,
   uint8_t payloadType = info.payloadType;
   packets_received_++;
 
-  AVPacket *packet = av_packet_alloc();
+  AVPacketPtr packet = make_av_packet();
   if (packet) {
-    if (av_new_packet(packet, static_cast<int>(data.size())) == 0) {
+    if (av_new_packet(packet.get(), static_cast<int>(data.size())) == 0) {
       std::memcpy(packet->data, data.data(), data.size());
     } else {
-      av_packet_free(&packet);
       return;
     }
 
     packet->pts = timestamp_us;
     packet->dts = timestamp_us;
 
-    // 当队列满时丢弃旧数据包以降低延迟
-    if (!decode_queue_.try_push(packet)) {
-      av_packet_free(&packet);
-
+    // 当队列满时由队列丢弃数据包以降低延迟
+    if (!decode_queue_.try_push(std::move(packet))) {
       // 每隔一段时间输出警告信息
       static int drop_count = 0;
       if (++drop_count % 100 == 0) {
@@ -199,6 +209,9 @@ void AudioPlayer::receiveAudioData(const rtc::binary &data,
                   << "Total drops: " << drop_count << std::endl;
       }
     }
+    if (decode_task_) {
+      decode_task_->notify();
+    }
   }
 }
 
@@ -222,15 +235,13 @@ void AudioPlayer::audioCallback(Uint8 *stream, int len) {
   // 音量控制参数 (0-100%)
   float volume_scale = volume_.load();
 
-  AVFrame *frame = nullptr;
+  AVFramePtr frame;
   if (!audio_sample_queue_.try_pop(frame)) {
     // 队列为空，跳出循环
     return;
   }
 
   if (!frame || !frame->data[0] || frame->nb_samples <= 0) {
-    if (frame)
-      av_frame_free(&frame);
     return;
   }
 
@@ -259,42 +270,21 @@ void AudioPlayer::audioCallback(Uint8 *stream, int len) {
                        AUDIO_S16SYS, samples_needed * sizeof(int16_t),
                        static_cast<int>(volume_scale * SDL_MIX_MAXVOLUME));
   }
-
-  av_frame_free(&frame);
 }
 
-void AudioPlayer::decodeThread() {
-  std::cout << "Audio decode thread started" << std::endl;
-  std::string wav_filename = "captured_remote_audio.wav";
-  std::string ogg_filename = "captured_remote_audio.ogg";
-
-  AVFrame *decoded_frame = av_frame_alloc();
-  AVFrame *resampled_frame = av_frame_alloc();
-
-  if (!decoded_frame || !resampled_frame) {
-    std::cerr << "Failed to allocate frames" << std::endl;
-    if (decoded_frame)
-      av_frame_free(&decoded_frame);
-    if (resampled_frame)
-      av_frame_free(&resampled_frame);
-    return;
+bool AudioPlayer::decodeStep() {
+  AVPacketPtr packet;
+  for (size_t n = 0; n < kDecodeBatchSize && running_; ++n) {
+    if (!decode_queue_.try_pop(packet)) {
+      return false;
+    }
+    decodePacket(std::move(packet));
   }
+  return running_ && !decode_queue_.empty();
+}
 
-  auto last_log_time = std::chrono::steady_clock::now();
-  auto last_perf_time = last_log_time;
-  int packets_in_period = 0;
-
-  // 只在调试时保存音频文件
-  const bool enable_debug_save = false; // 默认关闭调试保存
-
-  // 标记是否已经初始化了重采样器
-  bool resampler_initialized = false;
-
-  // 标记是否已经初始化了SDL音频设备
-  bool sdl_initialized = false;
-
-  // 是否初始化了解码器
-  bool decoder_initialized = false;
+void AudioPlayer::decodePacket(AVPacketPtr packet) {
+  const std::string wav_filename = "captured_remote_audio.wav";
 
   // 输出音频参数
   int out_sample_rate = params_.out_sample_rate;
@@ -302,176 +292,151 @@ void AudioPlayer::decodeThread() {
   SDL_AudioFormat out_sample_fmt_sdl = AUDIO_S16SYS;
   AVSampleFormat out_sample_fmt = AV_SAMPLE_FMT_S16;
 
-  while (running_) {
-    AVPacket *packet = nullptr;
-    // 使用带超时的等待，避免线程无法及时退出
-    decode_queue_.wait_pop(packet);
+  // 音频设备无法打开时不再解码，收到的包直接丢弃
+  if (sdl_failed_) {
+    return;
+  }
 
-    if (!running_) {
-      if (packet)
-        av_packet_free(&packet);
-      break;
+  if (!decoder_initialized_) {
+    if (!opus_decoder_->open_decoder()) {
+      std::cerr << "Failed to initialize Opus decoder" << std::endl;
+      SDL_Quit();
+      exit(-100);
     }
-    if (!decoder_initialized) {
-      if (!opus_decoder_->open_decoder()) {
-        std::cerr << "Failed to initialize Opus decoder" << std::endl;
-        SDL_Quit();
-        exit(-100);
+    decoder_initialized_ = true;
+  }
+
+  packets_processed_++;
+
+  if (packet->size > 0 &&
+      opus_decoder_->decode_packet(packet.get(), decoded_frame_.get())) {
+    // Save OPUS
+    //      DebugUtils::save_opus_packet_to_ogg(packet, "opus_packets.ogg");
+    // 第一次成功解码后，获取实际参数并初始化SDL音频设备和重采样器
+    if (!sdl_initialized_) {
+      // 初始化SDL音频设备，使用实际参数
+      if (!initSDLAudio(out_sample_rate, out_channels, out_sample_fmt_sdl,
+                        decoded_frame_->nb_samples)) {
+        std::cerr << "Failed to initialize SDL audio, playback stopped"
+                  << std::endl;
+        sdl_failed_ = true;
+        return;
       }
+      sdl_initialized_ = true;
     }
 
-    packets_processed_++;
-    packets_in_period++;
-
-    if (packet->size > 0 &&
-        opus_decoder_->decode_packet(packet, decoded_frame)) {
-      // Save OPUS
-      //      DebugUtils::save_opus_packet_to_ogg(packet, "opus_packets.ogg");
-      // 第一次成功解码后，获取实际参数并初始化SDL音频设备和重采样器
-      if (!sdl_initialized) {
-        // 初始化SDL音频设备，使用实际参数
-        if (!initSDLAudio(out_sample_rate, out_channels, out_sample_fmt_sdl,
-                          decoded_frame->nb_samples)) {
-          std::cerr << "Failed to initialize SDL audio" << std::endl;
-          av_packet_free(&packet);
-          break;
+    if (!resampler_initialized_) {
+      // 获取实际解码参数
+      int actual_sample_rate = opus_decoder_->get_sample_rate();
+      int actual_channels = opus_decoder_->get_channels();
+      AVSampleFormat actual_sample_fmt = opus_decoder_->get_sample_fmt();
+
+      uint64_t out_channel_layout =
+          av_get_default_channel_layout(out_channels);
+      uint64_t in_channel_layout =
+          av_get_default_channel_layout(actual_channels);
+
+      // 配置重采样器：保持原始格式
+      swr_ctx_ = swr_alloc_set_opts(nullptr,
+                                    // 输出格式 - 与输入相同
+                                    out_channel_layout, out_sample_fmt,
+                                    out_sample_rate,
+                                    // 输入格式（Opus解码器输出）
+                                    in_channel_layout, actual_sample_fmt,
+                                    actual_sample_rate, 0, nullptr);
+
+      if (!swr_ctx_) {
+        std::cerr << "Failed to allocate resampler context" << std::endl;
+      } else {
+        int ret = swr_init(swr_ctx_);
+        if (ret < 0) {
+          std::cerr << "Failed to initialize resampler: " << ret << std::endl;
+          swr_free(&swr_ctx_);
+          swr_ctx_ = nullptr;
+        } else {
+          resampler_initialized_ = true;
+          std::cout << "Resampler initialized successfully" << std::endl;
+          std::cout << "Out sample rate: " << out_sample_rate << std::endl;
+          std::cout << "Out sample format: "
+                    << av_get_sample_fmt_name(out_sample_fmt) << std::endl;
+          std::cout << "Out channels: " << out_channels << std::endl;
+          std::cout << "Volume: " << params_.volume << std::endl;
         }
-        sdl_initialized = true;
       }
+    }
 
-      if (!resampler_initialized) {
-        // 获取实际解码参数
-        int actual_sample_rate = opus_decoder_->get_sample_rate();
-        int actual_channels = opus_decoder_->get_channels();
-        AVSampleFormat actual_sample_fmt = opus_decoder_->get_sample_fmt();
-
-        uint64_t out_channel_layout =
-            av_get_default_channel_layout(out_channels);
-        uint64_t in_channel_layout =
-            av_get_default_channel_layout(actual_channels);
-
-        // 配置重采样器：保持原始格式
-        swr_ctx_ = swr_alloc_set_opts(nullptr,
-                                      // 输出格式 - 与输入相同
-                                      out_channel_layout, out_sample_fmt,
-                                      out_sample_rate,
-                                      // 输入格式（Opus解码器输出）
-                                      in_channel_layout, actual_sample_fmt,
-                                      actual_sample_rate, 0, nullptr);
+    if (resampler_initialized_) {
+      // 获取新的实际解码参数
+      AVSampleFormat actual_sample_fmt = opus_decoder_->get_sample_fmt();
+      int actual_sample_rate = opus_decoder_->get_sample_rate();
+      int actual_channels = opus_decoder_->get_channels();
+      // 设置输出帧参数
+      resampled_frame_->channel_layout =
+          av_get_default_channel_layout(out_channels);
+      resampled_frame_->sample_rate = out_sample_rate;
+      resampled_frame_->format = out_sample_fmt; // 强制输出为S16格式
+
+      int ret = swr_convert_frame(swr_ctx_, resampled_frame_.get(),
+                                  decoded_frame_.get());
+      if (ret == AVERROR_INPUT_CHANGED) {
+        std::cerr << "Audio resampling context needs reinitialization due to "
+                     "input change"
+                  << std::endl;
+        // 重新初始化重采样器
+        swr_free(&swr_ctx_);
+        swr_ctx_ = nullptr;
+
+        swr_ctx_ = swr_alloc_set_opts(
+            nullptr,
+            // 输出格式
+            av_get_default_channel_layout(out_channels), out_sample_fmt,
+            out_sample_rate,
+            // 输入格式（Opus解码器输出）
+            av_get_default_channel_layout(actual_channels), actual_sample_fmt,
+            actual_sample_rate, 0, nullptr);
 
         if (!swr_ctx_) {
           std::cerr << "Failed to allocate resampler context" << std::endl;
         } else {
-          int ret = swr_init(swr_ctx_);
-          if (ret < 0) {
-            std::cerr << "Failed to initialize resampler: " << ret << std::endl;
+          // 设置重采样器选项以提高质量
+          av_opt_set_double(swr_ctx_, "cutoff", 0.98, 0);
+          av_opt_set(swr_ctx_, "filter_type", "kaiser", 0);
+          av_opt_set_double(swr_ctx_, "kaiser_beta", 9.0, 0);
+
+          int init_ret = swr_init(swr_ctx_);
+          if (init_ret < 0) {
+            std::cerr << "Failed to reinitialize resampler: " << init_ret
+                      << std::endl;
             swr_free(&swr_ctx_);
             swr_ctx_ = nullptr;
           } else {
-            resampler_initialized = true;
-            std::cout << "Resampler initialized successfully" << std::endl;
-            std::cout << "Out sample rate: " << out_sample_rate << std::endl;
-            std::cout << "Out sample format: "
-                      << av_get_sample_fmt_name(out_sample_fmt) << std::endl;
-            std::cout << "Out channels: " << out_channels << std::endl;
-            std::cout << "Volume: " << params_.volume << std::endl;
-          }
-        }
-      }
-
-      if (resampler_initialized) {
-        // 获取新的实际解码参数
-        AVSampleFormat actual_sample_fmt = opus_decoder_->get_sample_fmt();
-        int actual_sample_rate = opus_decoder_->get_sample_rate();
-        int actual_channels = opus_decoder_->get_channels();
-        // 设置输出帧参数
-        resampled_frame->channel_layout =
-            av_get_default_channel_layout(out_channels);
-        resampled_frame->sample_rate = out_sample_rate;
-        resampled_frame->format = out_sample_fmt; // 强制输出为S16格式
-
-        int ret = swr_convert_frame(swr_ctx_, resampled_frame, decoded_frame);
-        if (ret == AVERROR_INPUT_CHANGED) {
-          std::cerr << "Audio resampling context needs reinitialization due to "
-                       "input change"
-                    << std::endl;
-          // 重新初始化重采样器
-          swr_free(&swr_ctx_);
-          swr_ctx_ = nullptr;
-
-          swr_ctx_ = swr_alloc_set_opts(
-              nullptr,
-              // 输出格式
-              av_get_default_channel_layout(out_channels), out_sample_fmt,
-              out_sample_rate,
-              // 输入格式（Opus解码器输出）
-              av_get_default_channel_layout(actual_channels), actual_sample_fmt,
-              actual_sample_rate, 0, nullptr);
-
-          if (!swr_ctx_) {
-            std::cerr << "Failed to allocate resampler context" << std::endl;
-          } else {
-            // 设置重采样器选项以提高质量
-            av_opt_set_double(swr_ctx_, "cutoff", 0.98, 0);
-            av_opt_set(swr_ctx_, "filter_type", "kaiser", 0);
-            av_opt_set_double(swr_ctx_, "kaiser_beta", 9.0, 0);
-
-            int init_ret = swr_init(swr_ctx_);
-            if (init_ret < 0) {
-              std::cerr << "Failed to reinitialize resampler: " << init_ret
-                        << std::endl;
-              swr_free(&swr_ctx_);
-              swr_ctx_ = nullptr;
-            } else {
-              // 重新尝试转换
-              ret = swr_convert_frame(swr_ctx_, resampled_frame, decoded_frame);
-              if (ret < 0) {
-                std::cerr << "Failed to resample audio frame after reinit: "
-                          << ret << std::endl;
-              }
-            }
-          }
-        } else if (ret < 0) {
-          char err_str[AV_ERROR_MAX_STRING_SIZE] = {0};
-          av_strerror(ret, err_str, sizeof(err_str));
-          std::cerr << "Failed to resample audio frame: " << ret << " ("
-                    << err_str << ")" << std::endl;
-        } else {
-          // 将重采样后的帧放入队列
-          DebugUtils::save_raw_audio_frame2(resampled_frame, wav_filename);
-          AVFrame *queue_frame = av_frame_alloc();
-          if (queue_frame) {
-            av_frame_move_ref(queue_frame, resampled_frame);
-
-            // 使用非阻塞推送
-            if (!audio_sample_queue_.try_push(queue_frame)) {
-              // 队列满时丢弃帧以降低延迟
-              av_frame_free(&queue_frame);
+            // 重新尝试转换
+            ret = swr_convert_frame(swr_ctx_, resampled_frame_.get(),
+                                    decoded_frame_.get());
+            if (ret < 0) {
+              std::cerr << "Failed to resample audio frame after reinit: "
+                        << ret << std::endl;
             }
           }
         }
+      } else if (ret < 0) {
+        char err_str[AV_ERROR_MAX_STRING_SIZE] = {0};
+        av_strerror(ret, err_str, sizeof(err_str));
+        std::cerr << "Failed to resample audio frame: " << ret << " ("
+                  << err_str << ")" << std::endl;
       } else {
-        std::cerr << "Resampler not initialized, skipping frame" << std::endl;
+        // 将重采样后的帧放入队列
+        DebugUtils::save_raw_audio_frame2(resampled_frame_.get(), wav_filename);
+        AVFramePtr queue_frame = make_av_frame();
+        if (queue_frame) {
+          av_frame_move_ref(queue_frame.get(), resampled_frame_.get());
+
+          // 使用非阻塞推送，队列满时由队列丢弃帧以降低延迟
+          audio_sample_queue_.try_push(std::move(queue_frame));
+        }
       }
+    } else {
+      std::cerr << "Resampler not initialized, skipping frame" << std::endl;
     }
-
-    av_packet_free(&packet);
-    // 性能统计和日志输出
-    //    auto now = std::chrono::steady_clock::now();
-    //    if (now - last_perf_time > std::chrono::seconds(5)) {
-    //      std::cout << "Audio decode: " << packets_in_period / 5.0 << "
-    //      packets/s, "
-    //                << "queue sizes: decode=" << decode_queue_.size()
-    //                << ", audio=" << audio_sample_queue_.size() << std::endl;
-    //      packets_in_period = 0;
-    //      last_perf_time = now;
-    //    }
   }
-
-  DebugUtils::finalize_raw_audio_frame_file2();
-  //  DebugUtils::finalize_opus_ogg_file();
-  av_frame_free(&decoded_frame);
-  av_frame_free(&resampled_frame);
-
-  std::cout << "Audio decode thread stopped" << std::endl;
-}
\ No newline at end of file
+}
@@ -0,0 +1,146 @@
+#include "av1_encoder.h"
+#include "codec_threads.h"
+#include "encoder.h"
+#include <cstring>
+#include <iostream>
+
+extern "C" {
+#include <libavutil/avutil.h>
+#include <libavutil/opt.h>
+}
+
+extern std::string av_error_string(int errnum);
+
+Av1Encoder::Av1Encoder(bool debug_enabled)
+    : debug_enabled_(debug_enabled), encoder_context_(nullptr),
+      codec_(nullptr) {}
+
+Av1Encoder::~Av1Encoder() { close_encoder(); }
+
+bool Av1Encoder::open_encoder(int width, int height, int fps, int64_t bit_rate) {
+  codec_ = avcodec_find_encoder_by_name("libaom-av1");
+  if (!codec_) {
+    codec_ = avcodec_find_encoder_by_name("libsvtav1");
+    if (!codec_) {
+      std::cerr << "Cannot find AV1 encoder (libaom-av1 or libsvtav1)"
+                << std::endl;
+      return false;
+    }
+  }
+  bool svt = strcmp(codec_->name, "libsvtav1") == 0;
+
+  encoder_context_ = avcodec_alloc_context3(codec_);
+  open_fps_ = fps;
+  open_bit_rate_ = bit_rate;
+
+  // ==================== 基础视频参数配置 ====================
+  encoder_context_->width = width;
+  encoder_context_->height = height;
+  encoder_context_->time_base = {1, fps};
+  encoder_context_->framerate = {fps, 1};
+  encoder_context_->max_b_frames = 0;
+  encoder_context_->pix_fmt = AV_PIX_FMT_YUV420P;
+  // 写入序列头的 color_range，像素格式仍为 YUV420P
+  encoder_context_->color_range =
+      full_range_ ? AVCOL_RANGE_JPEG : AVCOL_RANGE_MPEG;
+
+  // 码率控制：指定码率时使用 CBR，否则按质量编码
+  if (bit_rate > 0) {
+    encoder_context_->bit_rate = bit_rate;
+    encoder_context_->rc_min_rate = bit_rate;
+    encoder_context_->rc_max_rate = bit_rate;
+    encoder_context_->rc_buffer_size = bit_rate;
+  } else {
+    av_opt_set(encoder_context_->priv_data, svt ? "qp" : "crf", "35", 0);
+  }
+
+  CodecThreading threading = choose_encoder_threading(
+      width, height, requested_threads_, frame_threads_);
+  apply_codec_threading(encoder_context_, threading);
+  if (svt) {
+    // SVT-AV1 默认使用带前向参考的分层结构，需切换为低延迟预测结构；
+    // FFmpeg 4.4 没有 svtav1-params，只能关闭前向分析
+    av_opt_set(encoder_context_->priv_data, "preset", "8", 0);
+    av_opt_set(encoder_context_->priv_data, "la_depth", "0", 0);
+    av_opt_set(encoder_context_->priv_data, "svtav1-params",
+               "pred-struct=1:lookahead=0", 0);
+  } else {
+    av_opt_set(encoder_context_->priv_data, "usage", "realtime", 0);
+    av_opt_set(encoder_context_->priv_data, "cpu-used", "8", 0);
+    av_opt_set(encoder_context_->priv_data, "lag-in-frames", "0", 0);
+    av_opt_set_int(encoder_context_->priv_data, "row-mt", 1, 0);
+    av_opt_set_int(encoder_context_->priv_data, "tile-columns",
+                   tile_columns_log2(width, threading.thread_count), 0);
+  }
+
+  if (intra_refresh_) {
+    // 封装没有周期性帧内刷新，改为每秒一个关键帧，新观看者最多等待 1 秒
+    encoder_context_->gop_size = fps;
+    std::cout << "AV1 has no intra refresh, using " << fps
+              << "-frame keyframe interval" << std::endl;
+  }
+
+  std::cout << "AV1 Encoder (" << codec_->name << ") Using "
+            << encoder_context_->thread_count << " threads" << std::endl;
+
+  int ret = avcodec_open2(encoder_context_, codec_, nullptr);
+  if (ret < 0) {
+    std::cerr << "Cannot open AV1 encoder: " << av_error_string(ret)
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void Av1Encoder::close_encoder() {
+  if (encoder_context_) {
+    avcodec_free_context(&encoder_context_);
+    encoder_context_ = nullptr;
+  }
+}
+
+bool Av1Encoder::encode_frame(AVFrame *frame, AVPacket *packet) {
+  // Ensure frame has timestamp
+  static int64_t pts = 0;
+  if (frame && frame->pts == AV_NOPTS_VALUE) {
+    frame->pts = pts++;
+  }
+
+  // libaom/SVT-AV1 封装不支持运行中修改码率，在编码线程内以新码率重新打开；
+  // 失败时继续使用原编码器
+  int64_t bit_rate = 0;
+  if (take_rate_update(bit_rate) && !reopen_with_bit_rate(bit_rate)) {
+    std::cerr << "Cannot reopen AV1 encoder with new bitrate, keeping "
+                 "previous settings"
+              << std::endl;
+  }
+
+  if (frame) {
+    // 帧来自复用的帧池，每次都显式设置帧类型；I 帧被强制编码为关键帧
+    frame->pict_type = keyframe_requested_.exchange(false) ? AV_PICTURE_TYPE_I
+                                                           : AV_PICTURE_TYPE_NONE;
+  }
+
+  int ret = avcodec_send_frame(encoder_context_, frame);
+  if (ret < 0) {
+    return false;
+  }
+
+  ret = avcodec_receive_packet(encoder_context_, packet);
+  if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+    return false;
+  } else if (ret < 0) {
+    std::cerr << "Error receiving packet from encoder: " << av_error_string(ret)
+              << std::endl;
+    return false;
+  }
+
+  if (debug_enabled_) {
+    std::cout << "AV1 packet size: " << packet->size
+              << ", packet pts: " << packet->pts
+              << ", keyframe: " << (packet->flags & AV_PKT_FLAG_KEY)
+              << std::endl;
+  }
+
+  return true;
+}
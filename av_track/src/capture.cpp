@@ -11,23 +11,16 @@
 #include <random>
 #include <sstream>
 
-#ifdef __linux__
-#include <pthread.h>
-#include <sched.h>
-#include <sys/sysinfo.h>
-#endif
-
 #include "rtc/rtc.hpp"
 
 Capture::Capture(bool debug_enabled, size_t decode_queue_capacity,
                  size_t encode_queue_capacity, size_t send_queue_capacity)
     : debug_enabled_(debug_enabled), is_running_(false), is_paused_(false),
-      decode_queue_(decode_queue_capacity), encode_queue_(encode_queue_capacity), 
-      send_queue_(send_queue_capacity) {
+      // 每个队列只有一个生产者线程和一个消费者线程，使用无锁 SPSC 后端
+      decode_queue_(decode_queue_capacity, QueueBackend::Spsc),
+      encode_queue_(encode_queue_capacity, QueueBackend::Spsc),
+      send_queue_(send_queue_capacity, QueueBackend::Spsc) {
   avdevice_register_all();
-  decode_queue_.set_deleter([](AVPacket *packet) { av_packet_free(&packet); });
-  encode_queue_.set_deleter([](AVFrame *frame) { av_frame_free(&frame); });
-  send_queue_.set_deleter([](AVPacket *packet) { av_packet_free(&packet); });
 }
 
 Capture::~Capture() { stop(); }
@@ -77,21 +70,21 @@ void Capture::stop() {
   encode_queue_.stop();
   send_queue_.stop();
 
-  // 等待所有线程完成
+  // 等待采集线程完成
   if (capture_thread_.joinable()) {
     capture_thread_.join();
   }
 
-  if (decode_thread_.joinable()) {
-    decode_thread_.join();
-  }
-
-  if (encode_thread_.joinable()) {
-    encode_thread_.join();
+  // 按上游到下游的顺序关闭各阶段任务，关闭后不会再被上游唤醒
+  for (auto &task : stage_tasks_) {
+    if (task) {
+      task->close();
+      task.reset();
+    }
   }
 
-  if (send_thread_.joinable()) {
-    send_thread_.join();
+  if (stats_thread_.joinable()) {
+    stats_thread_.join();
   }
 
   // Encoder context is managed by the Encoder class
@@ -118,30 +111,112 @@ void Capture::resume_capture() {
   std::cout << "Capture resumed!!!" << std::endl;
 }
 
-int Capture::get_cpu_count() {
-#ifdef __linux__
-  return get_nprocs();
-#else
-  return 0; // 非Linux系统不支持CPU绑定
-#endif
-}
-
-void Capture::bind_thread_to_cpu(std::thread& thread, int cpu_id) {
-#ifdef __linux__
-  cpu_set_t cpuset;
-  CPU_ZERO(&cpuset);
-  CPU_SET(cpu_id, &cpuset);
-  
-  pthread_t thread_handle = thread.native_handle();
-  int result = pthread_setaffinity_np(thread_handle, sizeof(cpu_set_t), &cpuset);
-  
-  if (result == 0) {
-    std::cout << "Thread bound to CPU " << cpu_id << " successfully" << std::endl;
-  } else {
-    std::cerr << "Failed to bind thread to CPU " << cpu_id << ", error: " << result << std::endl;
+void Capture::start_stages(TaskPriority priority,
+                           std::initializer_list<PipelineStage> stages) {
+  for (PipelineStage stage : stages) {
+    std::function<bool()> step;
+    switch (stage) {
+    case PipelineStage::Decode:
+      step = [this] { return decode_step(); };
+      break;
+    case PipelineStage::Encode:
+      step = [this] { return encode_step(); };
+      break;
+    case PipelineStage::Send:
+      step = [this] { return send_step(); };
+      break;
+    }
+    stage_tasks_[static_cast<size_t>(stage)] =
+        std::make_unique<SerialTask>(Executor::shared(), priority, step);
   }
-#else
-  // 非Linux系统不执行绑定操作
-  std::cout << "CPU binding is only supported on Linux systems" << std::endl;
-#endif
+}
+
+void Capture::wake_stage(PipelineStage stage) {
+  const auto &task = stage_tasks_[static_cast<size_t>(stage)];
+  if (task) {
+    task->notify();
+  }
+}
+
+void Capture::set_queue_stats_interval(int seconds) {
+  queue_stats_interval_ = std::max(0, seconds);
+}
+
+void Capture::set_stage_budget_ms(PipelineStage stage, int budget_ms) {
+  stage_budget_us_[static_cast<size_t>(stage)] =
+      static_cast<int64_t>(std::max(0, budget_ms)) * 1000;
+}
+
+uint64_t Capture::stale_drops(PipelineStage stage) const {
+  return stale_drops_[static_cast<size_t>(stage)].load();
+}
+
+bool Capture::is_stale(PipelineStage stage, int64_t capture_us) {
+  size_t index = static_cast<size_t>(stage);
+  int64_t budget_us = stage_budget_us_[index].load(std::memory_order_relaxed);
+  if (budget_us <= 0 || capture_us <= 0 ||
+      steady_now_us() - capture_us <= budget_us) {
+    return false;
+  }
+  stale_drops_[index].fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void Capture::start_queue_stats(const std::string &label) {
+  if (queue_stats_interval_ <= 0) {
+    return;
+  }
+  decode_queue_.reset_stats();
+  encode_queue_.reset_stats();
+  send_queue_.reset_stats();
+  stats_thread_ = std::thread([this, label] {
+    std::unique_lock<std::mutex> lock(callback_mutex_);
+    while (is_running_) {
+      // stop() 会通知 callback_cv_，使统计线程及时退出
+      if (callback_cv_.wait_for(lock,
+                                std::chrono::seconds(queue_stats_interval_),
+                                [this] { return !is_running_.load(); })) {
+        break;
+      }
+      lock.unlock();
+      log_queue_stats(label);
+      lock.lock();
+    }
+  });
+}
+
+static std::string format_wait_histogram(
+    const std::array<uint64_t, QueueStats::kWaitBuckets> &histogram) {
+  // 依次对应 <0.1ms <1ms <5ms <20ms <100ms >=100ms
+  std::ostringstream oss;
+  oss << "[";
+  for (size_t i = 0; i < histogram.size(); ++i) {
+    oss << (i ? " " : "") << histogram[i];
+  }
+  oss << "]";
+  return oss.str();
+}
+
+template <typename T>
+static void log_one_queue(const std::string &label, const char *name,
+                          SafeQueue<T> &queue) {
+  QueueStats stats = queue.stats();
+  queue.reset_stats();
+  std::cout << "[" << label << "] " << name << " queue: size=" << stats.size
+            << "/" << stats.capacity << ", high_water=" << stats.high_water
+            << ", push=" << stats.pushes << ", pop=" << stats.pops
+            << ", drop=" << stats.drops << ", reject=" << stats.rejects
+            << ", producer_wait=" << format_wait_histogram(stats.producer_wait)
+            << ", consumer_wait=" << format_wait_histogram(stats.consumer_wait)
+            << std::endl;
+}
+
+void Capture::log_queue_stats(const std::string &label) {
+  log_one_queue(label, "decode", decode_queue_);
+  log_one_queue(label, "encode", encode_queue_);
+  log_one_queue(label, "send", send_queue_);
+  std::cout << "[" << label << "] stale drops: decode="
+            << stale_drops(PipelineStage::Decode)
+            << ", encode=" << stale_drops(PipelineStage::Encode)
+            << ", send=" << stale_drops(PipelineStage::Send) << std::endl;
 }
\ No newline at end of file
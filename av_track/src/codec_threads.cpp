@@ -0,0 +1,105 @@
+#include "codec_threads.h"
+#include <algorithm>
+#include <thread>
+
+namespace {
+// 每个线程至少分到的像素数，小分辨率下线程同步开销超过并行收益
+constexpr int kMinPixelsPerThread = 320 * 240;
+// slice 线程按行划分，每个线程至少分到的行数
+constexpr int kMinRowsPerSliceThread = 64;
+constexpr int kMaxDecoderThreads = 4;
+constexpr int kMaxEncoderThreads = 8;
+// 自动选择帧级线程时的上限，每多一个线程多一帧延迟
+constexpr int kMaxFrameThreads = 2;
+constexpr int kMinTileWidth = 256;
+
+int cpu_cores() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+int size_limit(int width, int height, int thread_type) {
+  int limit = std::max(1, width * height / kMinPixelsPerThread);
+  if (thread_type == FF_THREAD_SLICE) {
+    limit = std::min(limit, std::max(1, height / kMinRowsPerSliceThread));
+  }
+  return limit;
+}
+} // namespace
+
+CodecThreading choose_decoder_threading(const AVCodec *codec, int width,
+                                        int height, int requested_threads,
+                                        bool frame_threads) {
+  CodecThreading threading;
+  bool frame_capable = codec->capabilities & AV_CODEC_CAP_FRAME_THREADS;
+  bool slice_capable = codec->capabilities & AV_CODEC_CAP_SLICE_THREADS;
+  if (frame_threads && frame_capable) {
+    threading.thread_type = FF_THREAD_FRAME;
+  } else if (!slice_capable) {
+    // MJPEG、rawvideo 等不支持 slice 线程，未开启帧级线程时单线程解码
+    return threading;
+  }
+
+  if (requested_threads > 0) {
+    threading.thread_count = requested_threads;
+    return threading;
+  }
+  // 解码与采集、缩放、编码共享 CPU，最多使用一半的核
+  int cores = std::max(1, cpu_cores() / 2);
+  int max_threads = threading.thread_type == FF_THREAD_FRAME
+                        ? kMaxFrameThreads
+                        : kMaxDecoderThreads;
+  threading.thread_count =
+      std::min({cores, max_threads,
+                size_limit(width, height, threading.thread_type)});
+  return threading;
+}
+
+CodecThreading choose_encoder_threading(int width, int height,
+                                        int requested_threads,
+                                        bool frame_threads) {
+  CodecThreading threading;
+  // 帧级线程吞吐更高，但每个线程多一帧延迟，只在明确要求时使用
+  int cores = cpu_cores();
+  if (frame_threads) {
+    threading.thread_type = FF_THREAD_FRAME;
+  }
+
+  if (requested_threads > 0) {
+    threading.thread_count = requested_threads;
+    return threading;
+  }
+  // 给采集线程和解码/缩放任务留出一个核
+  int max_threads = threading.thread_type == FF_THREAD_FRAME
+                        ? kMaxFrameThreads
+                        : kMaxEncoderThreads;
+  threading.thread_count =
+      std::min({std::max(1, cores - 1), max_threads,
+                size_limit(width, height, threading.thread_type)});
+  return threading;
+}
+
+void apply_codec_threading(AVCodecContext *context,
+                           const CodecThreading &threading) {
+  context->thread_count = threading.thread_count;
+  context->thread_type = threading.thread_type;
+}
+
+int codec_threading_delay_frames(const CodecThreading &threading) {
+  return threading.thread_type == FF_THREAD_FRAME
+             ? std::max(0, threading.thread_count - 1)
+             : 0;
+}
+
+int tile_columns_log2(int width, int thread_count) {
+  int columns = std::min(std::max(1, width / kMinTileWidth),
+                         std::max(1, thread_count));
+  int log2 = 0;
+  while ((2 << log2) <= columns) {
+    ++log2;
+  }
+  return log2;
+}
+
+const char *codec_thread_type_name(int thread_type) {
+  return thread_type == FF_THREAD_FRAME ? "frame" : "slice";
+}
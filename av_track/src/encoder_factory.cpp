@@ -0,0 +1,57 @@
+#include "encoder_factory.h"
+#include "av1_encoder.h"
+#include "h264_encoder.h"
+#include "h265_encoder.h"
+#include "vpx_encoder.h"
+
+namespace {
+std::unique_ptr<Encoder> create_h264(bool debug_enabled) {
+  return std::make_unique<H264Encoder>(debug_enabled);
+}
+std::unique_ptr<Encoder> create_h265(bool debug_enabled) {
+  return std::make_unique<H265Encoder>(debug_enabled);
+}
+std::unique_ptr<Encoder> create_vp8(bool debug_enabled) {
+  return std::make_unique<VpxEncoder>(VpxEncoder::Codec::VP8, debug_enabled);
+}
+std::unique_ptr<Encoder> create_vp9(bool debug_enabled) {
+  return std::make_unique<VpxEncoder>(VpxEncoder::Codec::VP9, debug_enabled);
+}
+std::unique_ptr<Encoder> create_av1(bool debug_enabled) {
+  return std::make_unique<Av1Encoder>(debug_enabled);
+}
+
+const VideoCodecInfo kVideoCodecs[] = {
+    {"h264", "H.264", AV_CODEC_ID_H264, create_h264},
+    {"h265", "H.265", AV_CODEC_ID_HEVC, create_h265},
+    {"vp8", "VP8", AV_CODEC_ID_VP8, create_vp8},
+    {"vp9", "VP9", AV_CODEC_ID_VP9, create_vp9},
+    {"av1", "AV1", AV_CODEC_ID_AV1, create_av1},
+};
+} // namespace
+
+const VideoCodecInfo *find_video_codec(const std::string &name) {
+  for (const VideoCodecInfo &info : kVideoCodecs) {
+    if (name == info.name) {
+      return &info;
+    }
+  }
+  return nullptr;
+}
+
+std::string video_codec_names() {
+  std::string names;
+  for (const VideoCodecInfo &info : kVideoCodecs) {
+    if (!names.empty()) {
+      names += ", ";
+    }
+    names += info.name;
+  }
+  return names;
+}
+
+std::unique_ptr<Encoder> create_video_encoder(const std::string &name,
+                                              bool debug_enabled) {
+  const VideoCodecInfo *info = find_video_codec(name);
+  return info ? info->create(debug_enabled) : nullptr;
+}
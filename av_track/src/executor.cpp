@@ -0,0 +1,229 @@
+#include "executor.h"
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+namespace {
+// 当前线程所属的线程池及其工作线程序号，用于把任务提交到本线程的队列
+thread_local Executor *tls_executor = nullptr;
+thread_local size_t tls_worker_index = 0;
+} // namespace
+
+Executor::Executor(size_t thread_count) {
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (size_t i = 0; i < thread_count; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  // 所有 Worker 创建完成后再启动线程，窃取时才能安全地遍历 workers_
+  for (size_t i = 0; i < thread_count; ++i) {
+    workers_[i]->thread = std::thread(&Executor::worker_loop, this, i);
+  }
+  std::cout << "Executor started with " << thread_count << " worker threads"
+            << std::endl;
+}
+
+Executor::~Executor() {
+  {
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    stopping_ = true;
+  }
+  idle_cv_.notify_all();
+  for (auto &worker : workers_) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+}
+
+Executor &Executor::shared() {
+  static Executor executor;
+  return executor;
+}
+
+void Executor::submit(TaskPriority priority, std::function<void()> task) {
+  size_t index = tls_executor == this
+                     ? tls_worker_index
+                     : next_worker_.fetch_add(1, std::memory_order_relaxed) %
+                           workers_.size();
+  {
+    Worker &worker = *workers_[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.lanes[static_cast<size_t>(priority)].push_back(std::move(task));
+  }
+  {
+    // 在 idle_mutex_ 内计数，避免与即将休眠的线程错过唤醒
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    pending_.fetch_add(1);
+  }
+  idle_cv_.notify_one();
+}
+
+void Executor::parallel_for(TaskPriority priority, size_t count,
+                            const std::function<void(size_t)> &fn) {
+  if (count <= 1) {
+    if (count == 1) {
+      fn(0);
+    }
+    return;
+  }
+
+  // 状态由共享指针持有：调用返回后才被执行的任务领不到序号，只访问这里的计数
+  struct State {
+    const std::function<void(size_t)> *fn;
+    size_t count;
+    std::atomic<size_t> next{0};
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t done = 0;
+  };
+  auto state = std::make_shared<State>();
+  state->fn = &fn;
+  state->count = count;
+
+  auto work = [state] {
+    size_t finished = 0;
+    size_t index;
+    while ((index = state->next.fetch_add(1)) < state->count) {
+      (*state->fn)(index);
+      ++finished;
+    }
+    if (finished > 0) {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->done += finished;
+      if (state->done == state->count) {
+        state->cv.notify_all();
+      }
+    }
+  };
+
+  for (size_t i = 1; i < count; ++i) {
+    submit(priority, work);
+  }
+  work();
+
+  // 只等待已被其他线程领走、正在执行的部分
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->cv.wait(lock, [&] { return state->done == state->count; });
+}
+
+bool Executor::take_task(size_t index, std::function<void()> &task) {
+  size_t count = workers_.size();
+  for (size_t lane = 0; lane < kTaskPriorityCount; ++lane) {
+    // 先取本线程队尾（刚提交的任务数据还在缓存中）
+    {
+      Worker &own = *workers_[index];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (!own.lanes[lane].empty()) {
+        task = std::move(own.lanes[lane].back());
+        own.lanes[lane].pop_back();
+        pending_.fetch_sub(1);
+        return true;
+      }
+    }
+    // 再从其他线程的队头窃取
+    for (size_t i = 1; i < count; ++i) {
+      Worker &victim = *workers_[(index + i) % count];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.lanes[lane].empty()) {
+        task = std::move(victim.lanes[lane].front());
+        victim.lanes[lane].pop_front();
+        pending_.fetch_sub(1);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void Executor::worker_loop(size_t index) {
+  tls_executor = this;
+  tls_worker_index = index;
+
+  std::function<void()> task;
+  while (true) {
+    if (take_task(index, task)) {
+      try {
+        task();
+      } catch (const std::exception &e) {
+        std::cerr << "Executor task threw: " << e.what() << std::endl;
+      }
+      task = nullptr;
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    idle_cv_.wait(lock,
+                  [this] { return pending_.load() > 0 || stopping_.load(); });
+    // 退出前先把已提交的任务执行完
+    if (stopping_ && pending_.load() == 0) {
+      break;
+    }
+  }
+}
+
+SerialTask::SerialTask(Executor &executor, TaskPriority priority,
+                       std::function<bool()> step)
+    : executor_(executor), priority_(priority), step_(std::move(step)) {}
+
+SerialTask::~SerialTask() { close(); }
+
+void SerialTask::notify() {
+  if (closed_) {
+    return;
+  }
+  int state = state_.load();
+  while (true) {
+    if (state == kIdle) {
+      {
+        // 在锁内检查 closed_ 并离开空闲状态，与 close() 互斥：
+        // close() 要么先设置 closed_ 使这里放弃，要么等待这次调度的 run 结束
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        if (closed_) {
+          return;
+        }
+        if (!state_.compare_exchange_strong(state, kScheduled)) {
+          continue;
+        }
+      }
+      executor_.submit(priority_, [this] { run(); });
+      return;
+    } else if (state == kRunning) {
+      // 正在执行：标记一下，step 结束后再跑一轮，避免漏掉刚入队的数据
+      if (state_.compare_exchange_weak(state, kNotified)) {
+        return;
+      }
+    } else {
+      // 已在排队或已标记，无需重复提交
+      return;
+    }
+  }
+}
+
+void SerialTask::run() {
+  while (true) {
+    state_.store(kRunning);
+    bool more = !closed_ && step_();
+    if (more && !closed_) {
+      // 还有剩余数据：重新排队，让同车道的其他任务也能得到执行
+      executor_.submit(priority_, [this] { run(); });
+      return;
+    }
+    // 在锁内回到空闲状态，close() 返回之后本函数不会再访问任何成员
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    int expected = kRunning;
+    if (state_.compare_exchange_strong(expected, kIdle)) {
+      if (closed_) {
+        idle_cv_.notify_all();
+      }
+      return;
+    }
+  }
+}
+
+void SerialTask::close() {
+  std::unique_lock<std::mutex> lock(idle_mutex_);
+  closed_ = true;
+  idle_cv_.wait(lock, [this] { return state_.load() == kIdle; });
+}
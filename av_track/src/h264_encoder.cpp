@@ -1,4 +1,5 @@
 #include "h264_encoder.h"
+#include "codec_threads.h"
 #include "debug_utils.h"
 #include "encoder.h"
 #include <iostream>
@@ -29,6 +30,8 @@ bool H264Encoder::open_encoder(int width, int height, int fps, int64_t bit_rate)
   }
 
   encoder_context_ = avcodec_alloc_context3(codec_);
+  open_fps_ = fps;
+  open_bit_rate_ = bit_rate;
 
   // ==================== 基础视频参数配置 ====================
   encoder_context_->width = width;        // 视频宽度
@@ -55,18 +58,44 @@ bool H264Encoder::open_encoder(int width, int height, int fps, int64_t bit_rate)
 
   // 软编码配置
   encoder_context_->pix_fmt = AV_PIX_FMT_YUV420P; // 像素格式：YUV420平面格式
+  // 写入 VUI 的 video_full_range_flag，像素格式仍为 YUV420P
+  encoder_context_->color_range =
+      full_range_ ? AVCOL_RANGE_JPEG : AVCOL_RANGE_MPEG;
 
   // 设置编码器参数
   av_opt_set(encoder_context_->priv_data, "preset", "ultrafast", 0);
   av_opt_set(encoder_context_->priv_data, "tune", "zerolatency", 0);
   av_opt_set(encoder_context_->priv_data, "crf", "23", 0);
   av_opt_set(encoder_context_->priv_data, "profile", "baseline", 0);
+  av_opt_set(encoder_context_->priv_data, "forced-idr", "1", 0);
   encoder_context_->level = 31;
+  if (intra_refresh_) {
+    // 刷新周期为 keyint，每秒完成一轮；每轮开始的帧带恢复点 SEI 并标记为关键帧
+    encoder_context_->gop_size = fps;
+    av_opt_set(encoder_context_->priv_data, "intra-refresh", "1", 0);
+    std::cout << "H264 intra refresh enabled, period " << fps << " frames"
+              << std::endl;
+  }
+  if (max_slice_size_ > 0) {
+    // 低延迟模式下使用 slice 线程，各线程并行编码同一帧的不同 slice
+    std::string x264_params = "slice-max-size=" + std::to_string(max_slice_size_);
+    av_opt_set(encoder_context_->priv_data, "x264-params", x264_params.c_str(),
+               0);
+    std::cout << "H264 slices limited to " << max_slice_size_ << " bytes"
+              << std::endl;
+  }
 
-  // 设置线程用于并行编码
-  encoder_context_->thread_count = 2;
-  std::cout << "H264 Encoder Using " << encoder_context_->thread_count
-            << " threads" << std::endl;
+  // 设置线程用于并行编码。libx264 在 thread_type 非 0 时按它决定是否使用
+  // sliced-threads，会覆盖 zerolatency 的设置，因此线程类型需显式指定
+  CodecThreading threading = choose_encoder_threading(
+      width, height, requested_threads_, frame_threads_);
+  apply_codec_threading(encoder_context_, threading);
+  std::cout << "H264 Encoder Using " << encoder_context_->thread_count << " "
+            << codec_thread_type_name(threading.thread_type) << " threads";
+  if (int delay = codec_threading_delay_frames(threading)) {
+    std::cout << " (adds " << delay << " frames of latency)";
+  }
+  std::cout << std::endl;
 
   std::cout << "Encoder configured with GOP size: " << encoder_context_->gop_size
             << std::endl;
@@ -100,6 +129,31 @@ bool H264Encoder::encode_frame(AVFrame *frame, AVPacket *packet) {
     frame->pts = pts++;
   }
 
+  int64_t bit_rate = 0;
+  if (take_rate_update(bit_rate)) {
+    if ((bit_rate > 0) == (open_bit_rate_ > 0)) {
+      // libx264 在下一帧比较这些字段，变化时调用 x264_encoder_reconfig，不需要重新打开
+      encoder_context_->bit_rate = bit_rate;
+      encoder_context_->rc_max_rate = bit_rate;
+      encoder_context_->rc_buffer_size = bit_rate;
+      if (debug_enabled_) {
+        std::cout << "H264 rate control updated: " << bit_rate << " bps"
+                  << std::endl;
+      }
+    } else if (!reopen_with_bit_rate(bit_rate)) {
+      // x264 不能在运行中打开或关闭 VBV；重新打开失败时继续使用原编码器
+      std::cerr << "Cannot reopen H.264 encoder with new bitrate, keeping "
+                   "previous settings"
+                << std::endl;
+    }
+  }
+
+  if (frame) {
+    // 帧来自复用的帧池，每次都显式设置帧类型；forced-idr 使强制的 I 帧为 IDR
+    frame->pict_type = keyframe_requested_.exchange(false) ? AV_PICTURE_TYPE_I
+                                                           : AV_PICTURE_TYPE_NONE;
+  }
+
   int ret = avcodec_send_frame(encoder_context_, frame);
 
   if (ret < 0) {
@@ -0,0 +1,78 @@
+#include "h264_nal.h"
+#include <cstring>
+#include <iostream>
+
+namespace {
+const uint8_t kStartCode[4] = {0, 0, 0, 1};
+} // namespace
+
+bool h264_has_idr(const uint8_t *data, size_t size) {
+  bool has_idr = false;
+  for_each_h264_nal(data, size, [&](uint8_t type, const uint8_t *, size_t) {
+    if (type == kH264NalIdr) {
+      has_idr = true;
+    }
+  });
+  return has_idr;
+}
+
+void H264ParameterSets::process(AVPacket *packet) {
+  bool has_idr = false;
+  bool has_sps = false;
+  bool has_pps = false;
+  bool first_nal = true;
+  // 访问单元以 AUD 开头时参数集插在 AUD 之后，AUD 必须是访问单元的第一个 NAL
+  size_t insert_at = 0;
+  for_each_h264_nal(packet->data, packet->size,
+                    [&](uint8_t type, const uint8_t *nal, size_t size) {
+                      if (first_nal && type == kH264NalAud) {
+                        insert_at = nal + size - packet->data;
+                      }
+                      first_nal = false;
+                      if (type == kH264NalSps) {
+                        sps_.assign(nal, nal + size);
+                        has_sps = true;
+                      } else if (type == kH264NalPps) {
+                        pps_.assign(nal, nal + size);
+                        has_pps = true;
+                      } else if (type == kH264NalIdr) {
+                        has_idr = true;
+                      }
+                    });
+
+  if (!has_idr || (has_sps && has_pps) || !ready()) {
+    return;
+  }
+
+  // 新包内容：[AUD]、起始码+SPS、起始码+PPS、访问单元其余部分
+  size_t extra = sizeof(kStartCode) * 2 + sps_.size() + pps_.size();
+  AVPacket *merged = av_packet_alloc();
+  if (!merged || av_new_packet(merged, packet->size + extra) < 0) {
+    std::cerr << "Failed to allocate packet for SPS/PPS injection"
+              << std::endl;
+    av_packet_free(&merged);
+    return;
+  }
+  uint8_t *out = merged->data;
+  memcpy(out, packet->data, insert_at);
+  out += insert_at;
+  memcpy(out, kStartCode, sizeof(kStartCode));
+  out += sizeof(kStartCode);
+  memcpy(out, sps_.data(), sps_.size());
+  out += sps_.size();
+  memcpy(out, kStartCode, sizeof(kStartCode));
+  out += sizeof(kStartCode);
+  memcpy(out, pps_.data(), pps_.size());
+  out += pps_.size();
+  memcpy(out, packet->data + insert_at, packet->size - insert_at);
+
+  av_packet_copy_props(merged, packet);
+  av_packet_unref(packet);
+  av_packet_move_ref(packet, merged);
+  av_packet_free(&merged);
+}
+
+void H264ParameterSets::clear() {
+  sps_.clear();
+  pps_.clear();
+}
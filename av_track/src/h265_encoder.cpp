@@ -1,6 +1,8 @@
 #include "h265_encoder.h"
+#include "codec_threads.h"
 #include "debug_utils.h"
 #include "encoder.h"
+#include <algorithm>
 #include <iostream>
 
 extern "C" {
@@ -29,6 +31,8 @@ bool H265Encoder::open_encoder(int width, int height, int fps, int64_t bit_rate)
   }
 
   encoder_context_ = avcodec_alloc_context3(codec_);
+  open_fps_ = fps;
+  open_bit_rate_ = bit_rate;
 
   // ==================== 基础视频参数配置 ====================
   encoder_context_->width = width;        // 视频宽度
@@ -50,14 +54,48 @@ bool H265Encoder::open_encoder(int width, int height, int fps, int64_t bit_rate)
 
   // 软编码配置
   encoder_context_->pix_fmt = AV_PIX_FMT_YUV420P; // 像素格式：YUV420平面格式
+  // 写入 VUI 的 video_full_range_flag，像素格式仍为 YUV420P
+  encoder_context_->color_range =
+      full_range_ ? AVCOL_RANGE_JPEG : AVCOL_RANGE_MPEG;
 
   // 设置编码器参数
   av_opt_set(encoder_context_->priv_data, "preset", "ultrafast", 0);
   av_opt_set(encoder_context_->priv_data, "tune", "zerolatency", 0);
   av_opt_set(encoder_context_->priv_data, "crf", "28", 0); // H.265默认CRF值稍高，因为压缩效率更高
-
-  // 设置线程用于并行编码
-  encoder_context_->thread_count = 2;
+  av_opt_set(encoder_context_->priv_data, "forced-idr", "1", 0);
+  // libx265 封装没有单独的选项，以下设置都通过 x265-params 传入
+  std::string x265_params;
+  if (intra_refresh_) {
+    // 刷新周期为 keyint
+    encoder_context_->gop_size = fps;
+    x265_params += "intra-refresh=1:keyint=" + std::to_string(fps);
+    std::cout << "H265 intra refresh enabled, period " << fps << " frames"
+              << std::endl;
+  }
+  if (max_slice_size_ > 0 && bit_rate > 0) {
+    // x265 不支持按字节限制 slice 大小，按平均帧大小估算 slice 个数，
+    // 每个 CTU 行（64 像素）最多一个 slice
+    int64_t frame_bytes = bit_rate / 8 / fps;
+    int slices = static_cast<int>((frame_bytes + max_slice_size_ - 1) /
+                                  max_slice_size_);
+    slices = std::max(1, std::min(slices, std::max(1, height / 64)));
+    if (!x265_params.empty()) {
+      x265_params += ":";
+    }
+    x265_params += "slices=" + std::to_string(slices);
+    std::cout << "H265 using " << slices << " slices per frame" << std::endl;
+  }
+  // 设置线程用于并行编码。libx265 封装不读取 thread_count，线程池大小通过
+  // pools 传入；zerolatency 已将帧级线程限制为 1，线程用于 WPP 行并行
+  CodecThreading threading = choose_encoder_threading(
+      width, height, requested_threads_, frame_threads_);
+  apply_codec_threading(encoder_context_, threading);
+  if (!x265_params.empty()) {
+    x265_params += ":";
+  }
+  x265_params += "pools=" + std::to_string(threading.thread_count);
+  av_opt_set(encoder_context_->priv_data, "x265-params", x265_params.c_str(),
+             0);
   std::cout << "H265 Encoder Using " << encoder_context_->thread_count
             << " threads" << std::endl;
 
@@ -93,6 +131,21 @@ bool H265Encoder::encode_frame(AVFrame *frame, AVPacket *packet) {
     frame->pts = pts++;
   }
 
+  // libx265 封装不支持运行中修改码率，在编码线程内以新码率重新打开；
+  // 失败时继续使用原编码器
+  int64_t bit_rate = 0;
+  if (take_rate_update(bit_rate) && !reopen_with_bit_rate(bit_rate)) {
+    std::cerr << "Cannot reopen H.265 encoder with new bitrate, keeping "
+                 "previous settings"
+              << std::endl;
+  }
+
+  if (frame) {
+    // 帧来自复用的帧池，每次都显式设置帧类型；forced-idr 使强制的 I 帧为 IDR
+    frame->pict_type = keyframe_requested_.exchange(false) ? AV_PICTURE_TYPE_I
+                                                           : AV_PICTURE_TYPE_NONE;
+  }
+
   int ret = avcodec_send_frame(encoder_context_, frame);
 
   if (ret < 0) {
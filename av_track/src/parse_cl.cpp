@@ -17,6 +17,7 @@
 **
 ******************************************************************************/
 
+#include <stdio.h>
 #include <stdlib.h>
 
 #if defined(_WIN32) || defined(WIN32)
@@ -64,7 +65,7 @@ Cmdline::Cmdline(int argc,
       {"videoFormat", required_argument, NULL,
        'V'}, // Video input format option
       {"videoCodec", required_argument, NULL,
-       'E'}, // Video codec option (h264 or h265)
+       'E'}, // Video codec option (h264, h265, vp8, vp9 or av1)
       {"client_id", required_argument, NULL, 'c'},
       {"debug", no_argument, NULL, 'd'},
       {"resolution", required_argument, NULL, 'R'},
@@ -73,6 +74,21 @@ Cmdline::Cmdline(int argc,
       {"outChannels", required_argument, NULL, 'H'},
       {"outFormat", required_argument, NULL, 'G'},
       {"volume", required_argument, NULL, 'v'},
+      {"queueStats", required_argument, NULL, 'q'},
+      {"stageBudget", required_argument, NULL, 'b'},
+      {"fusedPipeline", no_argument, NULL, 'L'},
+      {"cameraPassthrough", no_argument, NULL, 'T'},
+      {"outResolution", required_argument, NULL, 'o'},
+      {"scaleThreads", required_argument, NULL, 'Z'},
+      {"rotation", required_argument, NULL, 'y'},
+      {"mirror", no_argument, NULL, 'M'},
+      {"idleGrace", required_argument, NULL, 'I'},
+      {"intraRefresh", no_argument, NULL, 'j'},
+      {"noJoinIdr", no_argument, NULL, 'J'},
+      {"lowLatencySlices", no_argument, NULL, 'l'},
+      {"decoderThreads", required_argument, NULL, 'D'},
+      {"encoderThreads", required_argument, NULL, 'K'},
+      {"frameThreads", no_argument, NULL, 'z'},
       {"help", no_argument, NULL, 'h'},
       {NULL, 0, NULL, 0}};
 
@@ -112,9 +128,27 @@ Cmdline::Cmdline(int argc,
   _out_channels = 2;        // Default output channels
   _volume = 0.8f;           // Default volume (80%)
 
+  _queueStats = 0; // Queue statistics disabled by default
+  _decodeBudget = 0; // Stage latency budgets disabled by default
+  _encodeBudget = 0;
+  _sendBudget = 0;
+  _fusedPipeline = false; // Separate decode/encode threads by default
+  _cameraPassthrough = false; // Decode and re-encode camera input by default
+  _outResolution = "";        // Encode at the capture resolution by default
+  _scaleThreads = 0;          // Pick the scaler slice count automatically
+  _rotation = 0;              // No rotation by default
+  _mirror = false;
+  _idleGrace = 10;            // Keep the camera warm for 10s after the last viewer leaves
+  _intraRefresh = false;      // Periodic IDR frames by default
+  _noJoinIdr = false;         // Browsers only start decoding H.264 at an IDR
+  _lowLatencySlices = false;  // Slice size left to the encoder by default
+  _decoderThreads = 0;        // Pick the decoder thread count automatically
+  _encoderThreads = 0;        // Pick the encoder thread count automatically
+  _frameThreads = false;      // Slice threads only by default, no added frame delay
+
   optind = 0;
   while ((c = getopt_long(argc, argv,
-                          "a:S:s:t:w:x:u:p:U:R:P:C:i:c:r:f:F:V:E:O:H:v:denmh",
+                          "a:S:s:t:w:x:u:p:U:R:P:C:i:c:r:f:F:V:E:O:H:v:q:b:o:Z:y:I:D:K:LTMjJldenmzh",
                           long_options, &optind)) != -1) {
     switch (c) {
     case 'n':
@@ -237,6 +271,18 @@ Cmdline::Cmdline(int argc,
       _resolution = optarg;
       break;
 
+    case 'o': {
+      int width = 0, height = 0;
+      if (sscanf(optarg, "%dx%d", &width, &height) != 2 || width <= 0 ||
+          height <= 0) {
+        std::string err;
+        err += "parameter range error: outResolution must be WIDTHxHEIGHT";
+        throw(std::range_error(err));
+      }
+      _outResolution = optarg;
+      break;
+    }
+
     case 'F':
       _framerate = atoi(optarg);
       if (_framerate < 1 || _framerate > 120) {
@@ -273,6 +319,100 @@ Cmdline::Cmdline(int argc,
       }
       break;
 
+    case 'q': // Queue statistics interval
+      _queueStats = atoi(optarg);
+      if (_queueStats < 0) {
+        std::string err;
+        err += "parameter range error: queue stats interval must be >= 0";
+        throw(std::range_error(err));
+      }
+      break;
+
+    case 'b': // Stage latency budgets: decode,encode,send (ms)
+      if (sscanf(optarg, "%d,%d,%d", &_decodeBudget, &_encodeBudget,
+                 &_sendBudget) != 3 ||
+          _decodeBudget < 0 || _encodeBudget < 0 || _sendBudget < 0) {
+        std::string err;
+        err += "parameter range error: stage budget must be DECODE,ENCODE,SEND "
+               "in ms, each >= 0";
+        throw(std::range_error(err));
+      }
+      break;
+
+    case 'L':
+      _fusedPipeline = true;
+      break;
+
+    case 'y':
+      _rotation = atoi(optarg);
+      if (_rotation != 0 && _rotation != 90 && _rotation != 180 &&
+          _rotation != 270) {
+        std::string err;
+        err += "parameter range error: rotation must be 0, 90, 180 or 270";
+        throw(std::range_error(err));
+      }
+      break;
+
+    case 'M':
+      _mirror = true;
+      break;
+
+    case 'Z':
+      _scaleThreads = atoi(optarg);
+      if (_scaleThreads < 0 || _scaleThreads > 16) {
+        std::string err;
+        err += "parameter range error: scaleThreads must be in [0,16]";
+        throw(std::range_error(err));
+      }
+      break;
+
+    case 'T':
+      _cameraPassthrough = true;
+      break;
+
+    case 'j':
+      _intraRefresh = true;
+      break;
+
+    case 'J':
+      _noJoinIdr = true;
+      break;
+
+    case 'l':
+      _lowLatencySlices = true;
+      break;
+
+    case 'D':
+      _decoderThreads = atoi(optarg);
+      if (_decoderThreads < 0 || _decoderThreads > 16) {
+        std::string err;
+        err += "parameter range error: decoderThreads must be in [0,16]";
+        throw(std::range_error(err));
+      }
+      break;
+
+    case 'K':
+      _encoderThreads = atoi(optarg);
+      if (_encoderThreads < 0 || _encoderThreads > 16) {
+        std::string err;
+        err += "parameter range error: encoderThreads must be in [0,16]";
+        throw(std::range_error(err));
+      }
+      break;
+
+    case 'z':
+      _frameThreads = true;
+      break;
+
+    case 'I':
+      _idleGrace = atoi(optarg);
+      if (_idleGrace < 0 || _idleGrace > 3600) {
+        std::string err;
+        err += "parameter range error: idleGrace must be in [0,3600]";
+        throw(std::range_error(err));
+      }
+      break;
+
     case 'd':
       _debug = true;
       break;
@@ -341,13 +481,15 @@ libdatachannel client implementing WebRTC Data Channels with WebSocket signaling
    [ -V ] [ --videoFormat ] (type=STRING, default=mjpeg)\n\
           Video input format.\n\
    [ -E ] [ --videoCodec ] (type=STRING, default=h264)\n\
-          Video codec (h264 or h265).\n\
+          Video codec (h264, h265, vp8, vp9 or av1).\n\
    [ -c ] [ --client_id ] (type=STRING)\n\
           Client identifier.\n\
    [ -d ] [ --debug ] (type=FLAG)\n\
           Enable debug output.\n\
    [ -R ] [ --resolution ] (type=STRING, default=640x480)\n\
           Video resolution in WIDTHxHEIGHT input_format.\n\
+   [ -o ] [ --outResolution ] (type=STRING, default=same as --resolution)\n\
+          Encoded video resolution in WIDTHxHEIGHT; MJPEG input is decoded at reduced size when possible.\n\
    [ -F ] [ --framerate ] (type=INTEGER, range=1...120, default=30)\n\
           Video encoding framerate.\n\
    [ -O ] [ --outSampleRate ] (type=INTEGER, default=48000)\n\
@@ -358,6 +500,35 @@ libdatachannel client implementing WebRTC Data Channels with WebSocket signaling
           Audio output format.\n\
    [ -v ] [ --volume ] (type=FLOAT, range=0.0...1.0, default=0.8)\n\
           Audio volume control.\n\
+   [ -q ] [ --queueStats ] (type=INTEGER, default=0)\n\
+          Log per-queue depth, drop and wait statistics every N seconds (0 disables).\n\
+   [ -b ] [ --stageBudget ] (type=STRING, default=0,0,0)\n\
+          Max age in ms (decode,encode,send) before a frame is dropped (0 disables).\n\
+   [ -L ] [ --fusedPipeline ] (type=FLAG)\n\
+          Decode, scale and encode in one pipeline task (for dual-core boards).\n\
+   [ -Z ] [ --scaleThreads ] (type=INTEGER, range=0...16, default=0)\n\
+          Horizontal slices scaled in parallel when resizing (0 = auto, 1 = single thread).\n\
+   [ -y ] [ --rotation ] (type=INTEGER, default=0)\n\
+          Rotate video clockwise by 0, 90, 180 or 270 degrees after scaling.\n\
+   [ -M ] [ --mirror ] (type=FLAG)\n\
+          Mirror video horizontally after rotation.\n\
+   [ -T ] [ --cameraPassthrough ] (type=FLAG)\n\
+          Forward the camera's own H.264 stream without decoding or re-encoding.\n\
+   [ -j ] [ --intraRefresh ] (type=FLAG)\n\
+          Spread intra blocks over each second of frames instead of sending periodic IDR frames.\n\
+   [ -J ] [ --noJoinIdr ] (type=FLAG)\n\
+          With --intraRefresh, let a new viewer wait for the next refresh cycle instead of forcing an IDR frame.\n\
+          Only for receivers that can start decoding without an IDR; browsers cannot.\n\
+   [ -l ] [ --lowLatencySlices ] (type=FLAG)\n\
+          Low-latency mode: MTU-sized slices sent as single RTP packets, slice threads only.\n\
+   [ -D ] [ --decoderThreads ] (type=INTEGER, range=0...16, default=0)\n\
+          Decoder threads (0 = auto from CPU cores and resolution).\n\
+   [ -K ] [ --encoderThreads ] (type=INTEGER, range=0...16, default=0)\n\
+          Encoder threads (0 = auto from CPU cores and resolution).\n\
+   [ -z ] [ --frameThreads ] (type=FLAG)\n\
+          Use frame threads instead of slice threads: more throughput, one extra frame of latency per thread. Ignored with --lowLatencySlices.\n\
+   [ -I ] [ --idleGrace ] (type=INTEGER, range=0...3600, default=10)\n\
+          Seconds the camera keeps streaming after the last viewer leaves before it is stopped.\n\
    [ -h ] [ --help ] (type=FLAG)\n\
           Display this help and exit.\n";
   }
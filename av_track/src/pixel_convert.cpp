@@ -0,0 +1,756 @@
+#include "pixel_convert.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PIXEL_CONVERT_X86 1
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PIXEL_CONVERT_NEON 1
+#endif
+
+namespace {
+
+// 每种实现提供的行级内核。宽度/数量参数均以输出样本计
+struct ConvertKernels {
+  const char *name;
+  // 同尺寸 YUYV422：两行 YUYV 生成两行 Y 和一行 U/V（色度取两行平均）
+  void (*yuyv_rows)(const uint8_t *src0, const uint8_t *src1, uint8_t *y0,
+                    uint8_t *y1, uint8_t *u, uint8_t *v, int width);
+  // 同尺寸 NV12：一行交织的 UV 拆分为 U、V
+  void (*uv_split)(const uint8_t *uv, uint8_t *u, uint8_t *v, int count);
+  // 缩小一半：平面格式两行做 2x2 均值
+  void (*half_plane)(const uint8_t *src0, const uint8_t *src1, uint8_t *dst,
+                     int out_width);
+  // 缩小一半：交织 UV 两行做 2x2 均值并拆分
+  void (*half_uv)(const uint8_t *src0, const uint8_t *src1, uint8_t *u,
+                  uint8_t *v, int out_count);
+  // 缩小一半：两行 YUYV 生成一行 Y
+  void (*yuyv_half_luma)(const uint8_t *src0, const uint8_t *src1,
+                         uint8_t *dst, int out_width);
+  // 缩小一半：两行 YUYV 中相邻两个宏像素的色度取均值
+  void (*yuyv_half_chroma)(const uint8_t *src0, const uint8_t *src1,
+                           uint8_t *u, uint8_t *v, int out_count);
+  // 旋转：8x8 字节块转置，dst(i, j) = src(j, i)，步长可以为负以实现翻转
+  void (*transpose8x8)(const uint8_t *src, ptrdiff_t src_stride, uint8_t *dst,
+                       ptrdiff_t dst_stride);
+  // 旋转/镜像：一行像素左右反转
+  void (*reverse_row)(const uint8_t *src, uint8_t *dst, int width);
+};
+
+inline uint8_t avg2(int a, int b) { return static_cast<uint8_t>((a + b + 1) >> 1); }
+inline uint8_t avg4(int a, int b, int c, int d) {
+  return static_cast<uint8_t>((a + b + c + d + 2) >> 2);
+}
+
+// ---------------------------------------------------------------------------
+// 标量实现，同时用于处理 SIMD 实现剩余的尾部像素
+// ---------------------------------------------------------------------------
+
+void yuyv_rows_scalar(const uint8_t *src0, const uint8_t *src1, uint8_t *y0,
+                      uint8_t *y1, uint8_t *u, uint8_t *v, int width) {
+  for (int x = 0; x < width; x += 2) {
+    const uint8_t *a = src0 + x * 2;
+    const uint8_t *b = src1 + x * 2;
+    y0[x] = a[0];
+    y0[x + 1] = a[2];
+    y1[x] = b[0];
+    y1[x + 1] = b[2];
+    u[x / 2] = avg2(a[1], b[1]);
+    v[x / 2] = avg2(a[3], b[3]);
+  }
+}
+
+void uv_split_scalar(const uint8_t *uv, uint8_t *u, uint8_t *v, int count) {
+  for (int i = 0; i < count; ++i) {
+    u[i] = uv[i * 2];
+    v[i] = uv[i * 2 + 1];
+  }
+}
+
+void half_plane_scalar(const uint8_t *src0, const uint8_t *src1, uint8_t *dst,
+                       int out_width) {
+  for (int x = 0; x < out_width; ++x) {
+    dst[x] = avg4(src0[x * 2], src0[x * 2 + 1], src1[x * 2], src1[x * 2 + 1]);
+  }
+}
+
+void half_uv_scalar(const uint8_t *src0, const uint8_t *src1, uint8_t *u,
+                    uint8_t *v, int out_count) {
+  for (int i = 0; i < out_count; ++i) {
+    const uint8_t *a = src0 + i * 4;
+    const uint8_t *b = src1 + i * 4;
+    u[i] = avg4(a[0], a[2], b[0], b[2]);
+    v[i] = avg4(a[1], a[3], b[1], b[3]);
+  }
+}
+
+void yuyv_half_luma_scalar(const uint8_t *src0, const uint8_t *src1,
+                           uint8_t *dst, int out_width) {
+  for (int x = 0; x < out_width; ++x) {
+    const uint8_t *a = src0 + x * 4;
+    const uint8_t *b = src1 + x * 4;
+    dst[x] = avg4(a[0], a[2], b[0], b[2]);
+  }
+}
+
+void yuyv_half_chroma_scalar(const uint8_t *src0, const uint8_t *src1,
+                             uint8_t *u, uint8_t *v, int out_count) {
+  for (int i = 0; i < out_count; ++i) {
+    const uint8_t *a = src0 + i * 8;
+    const uint8_t *b = src1 + i * 8;
+    u[i] = avg4(a[1], a[5], b[1], b[5]);
+    v[i] = avg4(a[3], a[7], b[3], b[7]);
+  }
+}
+
+void transpose8x8_scalar(const uint8_t *src, ptrdiff_t src_stride,
+                         uint8_t *dst, ptrdiff_t dst_stride) {
+  for (int i = 0; i < 8; ++i) {
+    for (int j = 0; j < 8; ++j) {
+      dst[i * dst_stride + j] = src[j * src_stride + i];
+    }
+  }
+}
+
+void reverse_row_scalar(const uint8_t *src, uint8_t *dst, int width) {
+  for (int x = 0; x < width; ++x) {
+    dst[x] = src[width - 1 - x];
+  }
+}
+
+const ConvertKernels kScalarKernels = {
+    "scalar",           yuyv_rows_scalar,      uv_split_scalar,
+    half_plane_scalar,  half_uv_scalar,        yuyv_half_luma_scalar,
+    yuyv_half_chroma_scalar, transpose8x8_scalar, reverse_row_scalar};
+
+#if defined(PIXEL_CONVERT_X86) && defined(__SSE2__)
+// ---------------------------------------------------------------------------
+// SSE2：x86_64 上总是可用
+// ---------------------------------------------------------------------------
+
+// 每个 16 位元素的低字节
+inline __m128i low_bytes(__m128i v) {
+  return _mm_and_si128(v, _mm_set1_epi16(0x00ff));
+}
+
+// 交织的 UV 字节对：相邻两对取均值，结果在每个 32 位元素的低 16 位
+inline __m128i pair_average_uv(__m128i uv) {
+  __m128i avg = _mm_avg_epu8(uv, _mm_srli_epi32(uv, 16));
+  // 有符号扩展后再 packs，避免 0x8000 以上的值被饱和
+  return _mm_srai_epi32(_mm_slli_epi32(avg, 16), 16);
+}
+
+// 把 8 个 [U V] 16 位元素拆成低 8 字节 U、高 8 字节 V
+inline void store_uv8(__m128i uv_pairs, uint8_t *u, uint8_t *v) {
+  __m128i split =
+      _mm_packus_epi16(low_bytes(uv_pairs), _mm_srli_epi16(uv_pairs, 8));
+  _mm_storel_epi64(reinterpret_cast<__m128i *>(u), split);
+  _mm_storel_epi64(reinterpret_cast<__m128i *>(v), _mm_srli_si128(split, 8));
+}
+
+inline __m128i load16(const uint8_t *p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+inline void store16(uint8_t *p, __m128i v) {
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+}
+
+void yuyv_rows_sse2(const uint8_t *src0, const uint8_t *src1, uint8_t *y0,
+                    uint8_t *y1, uint8_t *u, uint8_t *v, int width) {
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i a0 = load16(src0 + x * 2);
+    __m128i a1 = load16(src0 + x * 2 + 16);
+    __m128i b0 = load16(src1 + x * 2);
+    __m128i b1 = load16(src1 + x * 2 + 16);
+    store16(y0 + x, _mm_packus_epi16(low_bytes(a0), low_bytes(a1)));
+    store16(y1 + x, _mm_packus_epi16(low_bytes(b0), low_bytes(b1)));
+    __m128i chroma0 =
+        _mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(a1, 8));
+    __m128i chroma1 =
+        _mm_packus_epi16(_mm_srli_epi16(b0, 8), _mm_srli_epi16(b1, 8));
+    store_uv8(_mm_avg_epu8(chroma0, chroma1), u + x / 2, v + x / 2);
+  }
+  yuyv_rows_scalar(src0 + x * 2, src1 + x * 2, y0 + x, y1 + x, u + x / 2,
+                   v + x / 2, width - x);
+}
+
+void uv_split_sse2(const uint8_t *uv, uint8_t *u, uint8_t *v, int count) {
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i a = load16(uv + i * 2);
+    __m128i b = load16(uv + i * 2 + 16);
+    store16(u + i, _mm_packus_epi16(low_bytes(a), low_bytes(b)));
+    store16(v + i,
+            _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+  }
+  uv_split_scalar(uv + i * 2, u + i, v + i, count - i);
+}
+
+void half_plane_sse2(const uint8_t *src0, const uint8_t *src1, uint8_t *dst,
+                     int out_width) {
+  int x = 0;
+  for (; x + 16 <= out_width; x += 16) {
+    __m128i v0 = _mm_avg_epu8(load16(src0 + x * 2), load16(src1 + x * 2));
+    __m128i v1 =
+        _mm_avg_epu8(load16(src0 + x * 2 + 16), load16(src1 + x * 2 + 16));
+    __m128i h0 = _mm_avg_epu16(low_bytes(v0), _mm_srli_epi16(v0, 8));
+    __m128i h1 = _mm_avg_epu16(low_bytes(v1), _mm_srli_epi16(v1, 8));
+    store16(dst + x, _mm_packus_epi16(h0, h1));
+  }
+  half_plane_scalar(src0 + x * 2, src1 + x * 2, dst + x, out_width - x);
+}
+
+void half_uv_sse2(const uint8_t *src0, const uint8_t *src1, uint8_t *u,
+                  uint8_t *v, int out_count) {
+  int i = 0;
+  for (; i + 8 <= out_count; i += 8) {
+    __m128i v0 = _mm_avg_epu8(load16(src0 + i * 4), load16(src1 + i * 4));
+    __m128i v1 =
+        _mm_avg_epu8(load16(src0 + i * 4 + 16), load16(src1 + i * 4 + 16));
+    store_uv8(_mm_packs_epi32(pair_average_uv(v0), pair_average_uv(v1)),
+              u + i, v + i);
+  }
+  half_uv_scalar(src0 + i * 4, src1 + i * 4, u + i, v + i, out_count - i);
+}
+
+void yuyv_half_luma_sse2(const uint8_t *src0, const uint8_t *src1,
+                         uint8_t *dst, int out_width) {
+  int x = 0;
+  for (; x + 8 <= out_width; x += 8) {
+    __m128i luma0 = _mm_packus_epi16(low_bytes(load16(src0 + x * 4)),
+                                     low_bytes(load16(src0 + x * 4 + 16)));
+    __m128i luma1 = _mm_packus_epi16(low_bytes(load16(src1 + x * 4)),
+                                     low_bytes(load16(src1 + x * 4 + 16)));
+    __m128i vert = _mm_avg_epu8(luma0, luma1);
+    __m128i half = _mm_avg_epu16(low_bytes(vert), _mm_srli_epi16(vert, 8));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x),
+                     _mm_packus_epi16(half, half));
+  }
+  yuyv_half_luma_scalar(src0 + x * 4, src1 + x * 4, dst + x, out_width - x);
+}
+
+void yuyv_half_chroma_sse2(const uint8_t *src0, const uint8_t *src1,
+                           uint8_t *u, uint8_t *v, int out_count) {
+  int i = 0;
+  for (; i + 8 <= out_count; i += 8) {
+    __m128i pairs[2];
+    for (int half = 0; half < 2; ++half) {
+      const uint8_t *a = src0 + i * 8 + half * 32;
+      const uint8_t *b = src1 + i * 8 + half * 32;
+      __m128i chroma0 = _mm_packus_epi16(_mm_srli_epi16(load16(a), 8),
+                                         _mm_srli_epi16(load16(a + 16), 8));
+      __m128i chroma1 = _mm_packus_epi16(_mm_srli_epi16(load16(b), 8),
+                                         _mm_srli_epi16(load16(b + 16), 8));
+      pairs[half] = pair_average_uv(_mm_avg_epu8(chroma0, chroma1));
+    }
+    store_uv8(_mm_packs_epi32(pairs[0], pairs[1]), u + i, v + i);
+  }
+  yuyv_half_chroma_scalar(src0 + i * 8, src1 + i * 8, u + i, v + i,
+                          out_count - i);
+}
+
+void transpose8x8_sse2(const uint8_t *src, ptrdiff_t src_stride, uint8_t *dst,
+                       ptrdiff_t dst_stride) {
+  __m128i rows[8];
+  for (int i = 0; i < 8; ++i) {
+    rows[i] = _mm_loadl_epi64(
+        reinterpret_cast<const __m128i *>(src + i * src_stride));
+  }
+  // 逐级交织 8/16/32 位元素，最后每个寄存器包含转置后的两行
+  __m128i a0 = _mm_unpacklo_epi8(rows[0], rows[1]);
+  __m128i a1 = _mm_unpacklo_epi8(rows[2], rows[3]);
+  __m128i a2 = _mm_unpacklo_epi8(rows[4], rows[5]);
+  __m128i a3 = _mm_unpacklo_epi8(rows[6], rows[7]);
+  __m128i b0 = _mm_unpacklo_epi16(a0, a1);
+  __m128i b1 = _mm_unpackhi_epi16(a0, a1);
+  __m128i b2 = _mm_unpacklo_epi16(a2, a3);
+  __m128i b3 = _mm_unpackhi_epi16(a2, a3);
+  __m128i out[4] = {_mm_unpacklo_epi32(b0, b2), _mm_unpackhi_epi32(b0, b2),
+                    _mm_unpacklo_epi32(b1, b3), _mm_unpackhi_epi32(b1, b3)};
+  for (int i = 0; i < 4; ++i) {
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + (i * 2) * dst_stride),
+                     out[i]);
+    _mm_storel_epi64(
+        reinterpret_cast<__m128i *>(dst + (i * 2 + 1) * dst_stride),
+        _mm_srli_si128(out[i], 8));
+  }
+}
+
+void reverse_row_sse2(const uint8_t *src, uint8_t *dst, int width) {
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i v = load16(src + width - x - 16);
+    // 依次反转 32 位、16 位和字节的顺序
+    v = _mm_shuffle_epi32(v, 0x1B);
+    v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    store16(dst + x, v);
+  }
+  reverse_row_scalar(src, dst + x, width - x);
+}
+
+const ConvertKernels kSse2Kernels = {
+    "sse2",          yuyv_rows_sse2,      uv_split_sse2,
+    half_plane_sse2, half_uv_sse2,        yuyv_half_luma_sse2,
+    yuyv_half_chroma_sse2, transpose8x8_sse2, reverse_row_sse2};
+
+// ---------------------------------------------------------------------------
+// AVX2：运行时检测，只加速最常用的同尺寸转换，缩小一半仍使用 SSE2
+// ---------------------------------------------------------------------------
+
+#define PIXEL_CONVERT_AVX2 __attribute__((target("avx2")))
+
+PIXEL_CONVERT_AVX2 inline __m256i load32(const uint8_t *p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+// packus 按 128 位通道交错，重新排列为顺序结果
+PIXEL_CONVERT_AVX2 inline __m256i packus_ordered(__m256i a, __m256i b) {
+  return _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+}
+
+PIXEL_CONVERT_AVX2 void yuyv_rows_avx2(const uint8_t *src0,
+                                       const uint8_t *src1, uint8_t *y0,
+                                       uint8_t *y1, uint8_t *u, uint8_t *v,
+                                       int width) {
+  const __m256i mask = _mm256_set1_epi16(0x00ff);
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    __m256i a0 = load32(src0 + x * 2);
+    __m256i a1 = load32(src0 + x * 2 + 32);
+    __m256i b0 = load32(src1 + x * 2);
+    __m256i b1 = load32(src1 + x * 2 + 32);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(y0 + x),
+                        packus_ordered(_mm256_and_si256(a0, mask),
+                                       _mm256_and_si256(a1, mask)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(y1 + x),
+                        packus_ordered(_mm256_and_si256(b0, mask),
+                                       _mm256_and_si256(b1, mask)));
+    __m256i chroma = _mm256_avg_epu8(
+        packus_ordered(_mm256_srli_epi16(a0, 8), _mm256_srli_epi16(a1, 8)),
+        packus_ordered(_mm256_srli_epi16(b0, 8), _mm256_srli_epi16(b1, 8)));
+    __m256i split = packus_ordered(_mm256_and_si256(chroma, mask),
+                                   _mm256_srli_epi16(chroma, 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(u + x / 2),
+                     _mm256_castsi256_si128(split));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(v + x / 2),
+                     _mm256_extracti128_si256(split, 1));
+  }
+  yuyv_rows_sse2(src0 + x * 2, src1 + x * 2, y0 + x, y1 + x, u + x / 2,
+                 v + x / 2, width - x);
+}
+
+PIXEL_CONVERT_AVX2 void uv_split_avx2(const uint8_t *uv, uint8_t *u,
+                                      uint8_t *v, int count) {
+  const __m256i mask = _mm256_set1_epi16(0x00ff);
+  int i = 0;
+  for (; i + 32 <= count; i += 32) {
+    __m256i a = load32(uv + i * 2);
+    __m256i b = load32(uv + i * 2 + 32);
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i *>(u + i),
+        packus_ordered(_mm256_and_si256(a, mask), _mm256_and_si256(b, mask)));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i *>(v + i),
+        packus_ordered(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8)));
+  }
+  uv_split_sse2(uv + i * 2, u + i, v + i, count - i);
+}
+
+const ConvertKernels kAvx2Kernels = {
+    "avx2",          yuyv_rows_avx2,      uv_split_avx2,
+    half_plane_sse2, half_uv_sse2,        yuyv_half_luma_sse2,
+    yuyv_half_chroma_sse2, transpose8x8_sse2, reverse_row_sse2};
+#endif // PIXEL_CONVERT_X86 && __SSE2__
+
+#if defined(PIXEL_CONVERT_NEON)
+// ---------------------------------------------------------------------------
+// NEON：结构化加载直接完成去交织，舍入与标量实现一致
+// ---------------------------------------------------------------------------
+
+void yuyv_rows_neon(const uint8_t *src0, const uint8_t *src1, uint8_t *y0,
+                    uint8_t *y1, uint8_t *u, uint8_t *v, int width) {
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    // val[0]/val[2] 为偶/奇像素的 Y，val[1] 为 U，val[3] 为 V
+    uint8x16x4_t a = vld4q_u8(src0 + x * 2);
+    uint8x16x4_t b = vld4q_u8(src1 + x * 2);
+    uint8x16x2_t luma0 = {{a.val[0], a.val[2]}};
+    uint8x16x2_t luma1 = {{b.val[0], b.val[2]}};
+    vst2q_u8(y0 + x, luma0);
+    vst2q_u8(y1 + x, luma1);
+    vst1q_u8(u + x / 2, vrhaddq_u8(a.val[1], b.val[1]));
+    vst1q_u8(v + x / 2, vrhaddq_u8(a.val[3], b.val[3]));
+  }
+  yuyv_rows_scalar(src0 + x * 2, src1 + x * 2, y0 + x, y1 + x, u + x / 2,
+                   v + x / 2, width - x);
+}
+
+void uv_split_neon(const uint8_t *uv, uint8_t *u, uint8_t *v, int count) {
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    uint8x16x2_t split = vld2q_u8(uv + i * 2);
+    vst1q_u8(u + i, split.val[0]);
+    vst1q_u8(v + i, split.val[1]);
+  }
+  uv_split_scalar(uv + i * 2, u + i, v + i, count - i);
+}
+
+// 两行各 16 个字节，相邻两个相加后再加上另一行，结果 (sum + 2) >> 2
+inline uint8x8_t box_average(uint8x16_t row0, uint8x16_t row1) {
+  return vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(row0), row1), 2);
+}
+
+void half_plane_neon(const uint8_t *src0, const uint8_t *src1, uint8_t *dst,
+                     int out_width) {
+  int x = 0;
+  for (; x + 16 <= out_width; x += 16) {
+    uint8x8_t lo = box_average(vld1q_u8(src0 + x * 2), vld1q_u8(src1 + x * 2));
+    uint8x8_t hi =
+        box_average(vld1q_u8(src0 + x * 2 + 16), vld1q_u8(src1 + x * 2 + 16));
+    vst1q_u8(dst + x, vcombine_u8(lo, hi));
+  }
+  half_plane_scalar(src0 + x * 2, src1 + x * 2, dst + x, out_width - x);
+}
+
+void half_uv_neon(const uint8_t *src0, const uint8_t *src1, uint8_t *u,
+                  uint8_t *v, int out_count) {
+  int i = 0;
+  for (; i + 8 <= out_count; i += 8) {
+    uint8x16x2_t a = vld2q_u8(src0 + i * 4);
+    uint8x16x2_t b = vld2q_u8(src1 + i * 4);
+    vst1_u8(u + i, box_average(a.val[0], b.val[0]));
+    vst1_u8(v + i, box_average(a.val[1], b.val[1]));
+  }
+  half_uv_scalar(src0 + i * 4, src1 + i * 4, u + i, v + i, out_count - i);
+}
+
+void yuyv_half_luma_neon(const uint8_t *src0, const uint8_t *src1,
+                         uint8_t *dst, int out_width) {
+  int x = 0;
+  for (; x + 16 <= out_width; x += 16) {
+    uint8x16x4_t a = vld4q_u8(src0 + x * 4);
+    uint8x16x4_t b = vld4q_u8(src1 + x * 4);
+    // 每个宏像素的两个 Y 相加，再加上另一行
+    uint16x8_t lo = vaddl_u8(vget_low_u8(a.val[0]), vget_low_u8(a.val[2]));
+    uint16x8_t hi = vaddl_u8(vget_high_u8(a.val[0]), vget_high_u8(a.val[2]));
+    lo = vaddq_u16(lo, vaddl_u8(vget_low_u8(b.val[0]), vget_low_u8(b.val[2])));
+    hi = vaddq_u16(hi,
+                   vaddl_u8(vget_high_u8(b.val[0]), vget_high_u8(b.val[2])));
+    vst1q_u8(dst + x, vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2)));
+  }
+  yuyv_half_luma_scalar(src0 + x * 4, src1 + x * 4, dst + x, out_width - x);
+}
+
+void yuyv_half_chroma_neon(const uint8_t *src0, const uint8_t *src1,
+                           uint8_t *u, uint8_t *v, int out_count) {
+  int i = 0;
+  for (; i + 8 <= out_count; i += 8) {
+    uint8x16x4_t a = vld4q_u8(src0 + i * 8);
+    uint8x16x4_t b = vld4q_u8(src1 + i * 8);
+    vst1_u8(u + i, box_average(a.val[1], b.val[1]));
+    vst1_u8(v + i, box_average(a.val[3], b.val[3]));
+  }
+  yuyv_half_chroma_scalar(src0 + i * 8, src1 + i * 8, u + i, v + i,
+                          out_count - i);
+}
+
+void transpose8x8_neon(const uint8_t *src, ptrdiff_t src_stride, uint8_t *dst,
+                       ptrdiff_t dst_stride) {
+  uint8x8_t rows[8];
+  for (int i = 0; i < 8; ++i) {
+    rows[i] = vld1_u8(src + i * src_stride);
+  }
+  // 依次交换 8/16/32 位元素
+  uint8x8x2_t t0 = vtrn_u8(rows[0], rows[1]);
+  uint8x8x2_t t1 = vtrn_u8(rows[2], rows[3]);
+  uint8x8x2_t t2 = vtrn_u8(rows[4], rows[5]);
+  uint8x8x2_t t3 = vtrn_u8(rows[6], rows[7]);
+  uint16x4x2_t u0 = vtrn_u16(vreinterpret_u16_u8(t0.val[0]),
+                             vreinterpret_u16_u8(t1.val[0]));
+  uint16x4x2_t u1 = vtrn_u16(vreinterpret_u16_u8(t0.val[1]),
+                             vreinterpret_u16_u8(t1.val[1]));
+  uint16x4x2_t u2 = vtrn_u16(vreinterpret_u16_u8(t2.val[0]),
+                             vreinterpret_u16_u8(t3.val[0]));
+  uint16x4x2_t u3 = vtrn_u16(vreinterpret_u16_u8(t2.val[1]),
+                             vreinterpret_u16_u8(t3.val[1]));
+  uint32x2x2_t v0 = vtrn_u32(vreinterpret_u32_u16(u0.val[0]),
+                             vreinterpret_u32_u16(u2.val[0]));
+  uint32x2x2_t v1 = vtrn_u32(vreinterpret_u32_u16(u1.val[0]),
+                             vreinterpret_u32_u16(u3.val[0]));
+  uint32x2x2_t v2 = vtrn_u32(vreinterpret_u32_u16(u0.val[1]),
+                             vreinterpret_u32_u16(u2.val[1]));
+  uint32x2x2_t v3 = vtrn_u32(vreinterpret_u32_u16(u1.val[1]),
+                             vreinterpret_u32_u16(u3.val[1]));
+  uint32x2_t out[8] = {v0.val[0], v1.val[0], v2.val[0], v3.val[0],
+                       v0.val[1], v1.val[1], v2.val[1], v3.val[1]};
+  for (int i = 0; i < 8; ++i) {
+    vst1_u8(dst + i * dst_stride, vreinterpret_u8_u32(out[i]));
+  }
+}
+
+void reverse_row_neon(const uint8_t *src, uint8_t *dst, int width) {
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    uint8x16_t v = vrev64q_u8(vld1q_u8(src + width - x - 16));
+    vst1q_u8(dst + x, vcombine_u8(vget_high_u8(v), vget_low_u8(v)));
+  }
+  reverse_row_scalar(src, dst + x, width - x);
+}
+
+const ConvertKernels kNeonKernels = {
+    "neon",          yuyv_rows_neon,      uv_split_neon,
+    half_plane_neon, half_uv_neon,        yuyv_half_luma_neon,
+    yuyv_half_chroma_neon, transpose8x8_neon, reverse_row_neon};
+#endif // PIXEL_CONVERT_NEON
+
+const ConvertKernels &select_kernels() {
+#if defined(PIXEL_CONVERT_X86) && defined(__SSE2__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return kAvx2Kernels;
+  }
+  return kSse2Kernels;
+#elif defined(PIXEL_CONVERT_NEON)
+  return kNeonKernels;
+#else
+  return kScalarKernels;
+#endif
+}
+
+// 测试和基准强制指定的实现，为空时使用自动选择的实现
+std::atomic<const ConvertKernels *> forced_kernels{nullptr};
+
+const ConvertKernels &kernels() {
+  static const ConvertKernels &selected = select_kernels();
+  const ConvertKernels *forced =
+      forced_kernels.load(std::memory_order_relaxed);
+  return forced ? *forced : selected;
+}
+
+void convert_yuyv422(const AVFrame *src, AVFrame *dst, bool half) {
+  const ConvertKernels &k = kernels();
+  const uint8_t *s = src->data[0];
+  int stride = src->linesize[0];
+  for (int y = 0; y < dst->height; y += 2) {
+    uint8_t *u = dst->data[1] + (y / 2) * dst->linesize[1];
+    uint8_t *v = dst->data[2] + (y / 2) * dst->linesize[2];
+    uint8_t *y0 = dst->data[0] + y * dst->linesize[0];
+    uint8_t *y1 = y0 + dst->linesize[0];
+    if (!half) {
+      const uint8_t *row0 = s + y * stride;
+      k.yuyv_rows(row0, row0 + stride, y0, y1, u, v, dst->width);
+      continue;
+    }
+    // 输出两行亮度对应源的四行；色度取四行中间两行，与输出色度采样中心对齐
+    const uint8_t *row0 = s + (y * 2) * stride;
+    k.yuyv_half_luma(row0, row0 + stride, y0, dst->width);
+    k.yuyv_half_luma(row0 + 2 * stride, row0 + 3 * stride, y1, dst->width);
+    k.yuyv_half_chroma(row0 + stride, row0 + 2 * stride, u, v,
+                       dst->width / 2);
+  }
+}
+
+void convert_nv12(const AVFrame *src, AVFrame *dst, bool half) {
+  const ConvertKernels &k = kernels();
+  for (int y = 0; y < dst->height; ++y) {
+    uint8_t *out = dst->data[0] + y * dst->linesize[0];
+    if (!half) {
+      memcpy(out, src->data[0] + y * src->linesize[0], dst->width);
+    } else {
+      const uint8_t *row0 = src->data[0] + (y * 2) * src->linesize[0];
+      k.half_plane(row0, row0 + src->linesize[0], out, dst->width);
+    }
+  }
+  for (int y = 0; y < dst->height / 2; ++y) {
+    uint8_t *u = dst->data[1] + y * dst->linesize[1];
+    uint8_t *v = dst->data[2] + y * dst->linesize[2];
+    if (!half) {
+      k.uv_split(src->data[1] + y * src->linesize[1], u, v, dst->width / 2);
+    } else {
+      const uint8_t *row0 = src->data[1] + (y * 2) * src->linesize[1];
+      k.half_uv(row0, row0 + src->linesize[1], u, v, dst->width / 2);
+    }
+  }
+}
+
+// 单个平面的旋转/翻转。transpose 为 true 时 dst(r, c) = src(fy(c), fx(r))，
+// 否则 dst(r, c) = src(fy(r), fx(c))；flip_x/flip_y 表示 fx/fy 取反向坐标
+void transform_plane(const uint8_t *src, int src_stride, int src_width,
+                     int src_height, uint8_t *dst, int dst_stride,
+                     bool transpose, bool flip_x, bool flip_y) {
+  const ConvertKernels &k = kernels();
+  // 源图像的起点和行/列步长，翻转时从另一端开始反向遍历
+  const uint8_t *origin = src + (flip_y ? (src_height - 1) * src_stride : 0) +
+                          (flip_x ? src_width - 1 : 0);
+  ptrdiff_t row_step = flip_y ? -src_stride : src_stride;
+  ptrdiff_t col_step = flip_x ? -1 : 1;
+
+  if (!transpose) {
+    for (int r = 0; r < src_height; ++r) {
+      const uint8_t *row = src + (flip_y ? src_height - 1 - r : r) * src_stride;
+      uint8_t *out = dst + r * dst_stride;
+      if (flip_x) {
+        k.reverse_row(row, out, src_width);
+      } else {
+        memcpy(out, row, src_width);
+      }
+    }
+    return;
+  }
+
+  // 转置时目标宽为源的高，目标高为源的宽
+  int dst_width = src_height;
+  int dst_height = src_width;
+  int block_rows = dst_height & ~7;
+  int block_cols = dst_width & ~7;
+  for (int r0 = 0; r0 < block_rows; r0 += 8) {
+    for (int c0 = 0; c0 < block_cols; c0 += 8) {
+      // 列反向时按源的正向加载整块，再把转置结果自下而上写入
+      const uint8_t *block =
+          origin + c0 * row_step + (flip_x ? -(r0 + 7) : r0);
+      if (flip_x) {
+        k.transpose8x8(block, row_step, dst + (r0 + 7) * dst_stride + c0,
+                       -dst_stride);
+      } else {
+        k.transpose8x8(block, row_step, dst + r0 * dst_stride + c0,
+                       dst_stride);
+      }
+    }
+  }
+  // 不足 8 的右侧和底部边缘逐像素处理
+  for (int r = 0; r < dst_height; ++r) {
+    int c = r < block_rows ? block_cols : 0;
+    for (; c < dst_width; ++c) {
+      dst[r * dst_stride + c] = origin[c * row_step + r * col_step];
+    }
+  }
+}
+
+} // namespace
+
+const char *fast_convert_kernel_name() { return kernels().name; }
+
+bool set_fast_convert_kernel(const char *name) {
+  if (!name) {
+    forced_kernels = nullptr;
+    return true;
+  }
+  const ConvertKernels *selected = nullptr;
+  if (strcmp(name, kScalarKernels.name) == 0) {
+    selected = &kScalarKernels;
+  }
+#if defined(PIXEL_CONVERT_X86) && defined(__SSE2__)
+  if (strcmp(name, kSse2Kernels.name) == 0) {
+    selected = &kSse2Kernels;
+  }
+  __builtin_cpu_init();
+  if (strcmp(name, kAvx2Kernels.name) == 0 &&
+      __builtin_cpu_supports("avx2")) {
+    selected = &kAvx2Kernels;
+  }
+#endif
+#if defined(PIXEL_CONVERT_NEON)
+  if (strcmp(name, kNeonKernels.name) == 0) {
+    selected = &kNeonKernels;
+  }
+#endif
+  if (!selected) {
+    return false;
+  }
+  forced_kernels = selected;
+  return true;
+}
+
+bool fast_convert_supported(AVPixelFormat src_format, int src_width,
+                            int src_height, AVPixelFormat dst_format,
+                            int dst_width, int dst_height) {
+  if (dst_format != AV_PIX_FMT_YUV420P ||
+      (src_format != AV_PIX_FMT_YUYV422 && src_format != AV_PIX_FMT_NV12) ||
+      dst_width <= 0 || dst_height <= 0) {
+    return false;
+  }
+  // 只处理偶数尺寸，摄像头输出的分辨率总是满足
+  if (src_width == dst_width && src_height == dst_height) {
+    return dst_width % 2 == 0 && dst_height % 2 == 0;
+  }
+  if (src_width == dst_width * 2 && src_height == dst_height * 2) {
+    return dst_width % 2 == 0 && dst_height % 2 == 0;
+  }
+  return false;
+}
+
+bool fast_convert_frame(const AVFrame *src, AVFrame *dst) {
+  AVPixelFormat src_format = static_cast<AVPixelFormat>(src->format);
+  if (!fast_convert_supported(src_format, src->width, src->height,
+                              static_cast<AVPixelFormat>(dst->format),
+                              dst->width, dst->height)) {
+    return false;
+  }
+  bool half = src->width != dst->width;
+  if (src_format == AV_PIX_FMT_YUYV422) {
+    convert_yuyv422(src, dst, half);
+  } else {
+    convert_nv12(src, dst, half);
+  }
+  return true;
+}
+
+bool rotation_swaps_dimensions(int rotation) {
+  return rotation == 90 || rotation == 270;
+}
+
+bool rotate_frame(const AVFrame *src, AVFrame *dst, int rotation,
+                  bool mirror) {
+  AVPixelFormat src_format = static_cast<AVPixelFormat>(src->format);
+  if ((src_format != AV_PIX_FMT_YUV420P &&
+       src_format != AV_PIX_FMT_YUVJ420P) ||
+      dst->format != AV_PIX_FMT_YUV420P || src->width % 2 != 0 ||
+      src->height % 2 != 0) {
+    return false;
+  }
+  bool transpose = rotation_swaps_dimensions(rotation);
+  if ((transpose && (dst->width != src->height || dst->height != src->width)) ||
+      (!transpose && (dst->width != src->width || dst->height != src->height))) {
+    return false;
+  }
+
+  // 先顺时针旋转再水平镜像，换算成对源坐标的转置和翻转
+  bool flip_x = false;
+  bool flip_y = false;
+  switch (rotation) {
+  case 0:
+    flip_x = mirror;
+    break;
+  case 90:
+    flip_y = !mirror;
+    break;
+  case 180:
+    flip_x = !mirror;
+    flip_y = true;
+    break;
+  case 270:
+    flip_x = true;
+    flip_y = mirror;
+    break;
+  default:
+    return false;
+  }
+
+  for (int plane = 0; plane < 3; ++plane) {
+    int width = plane == 0 ? src->width : src->width / 2;
+    int height = plane == 0 ? src->height : src->height / 2;
+    transform_plane(src->data[plane], src->linesize[plane], width, height,
+                    dst->data[plane], dst->linesize[plane], transpose, flip_x,
+                    flip_y);
+  }
+  return true;
+}
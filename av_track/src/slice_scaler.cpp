@@ -0,0 +1,145 @@
+#include "slice_scaler.h"
+#include "executor.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+extern "C" {
+#include <libavutil/pixdesc.h>
+}
+
+namespace {
+// 每个条带至少包含的目标行数，太小时线程调度开销超过缩放本身
+constexpr int kMinBandRows = 64;
+constexpr int kMaxAutoSlices = 4;
+
+// 条带边界按 2 行对齐，保证 4:2:0 色度平面的行范围是整数
+int align_rows(int rows) { return rows & ~1; }
+
+// 平面 plane 中第 y 行亮度对应的行号
+int plane_row(const AVPixFmtDescriptor *desc, int plane, int y) {
+  bool is_chroma = (plane == 1 || plane == 2) &&
+                   !(desc->flags & AV_PIX_FMT_FLAG_RGB);
+  return is_chroma ? (y >> desc->log2_chroma_h) : y;
+}
+
+void set_full_range_output(SwsContext *context) {
+  int *inv_table = nullptr, *table = nullptr;
+  int src_range = 0, dst_range = 0, brightness = 0, contrast = 0,
+      saturation = 0;
+  if (sws_getColorspaceDetails(context, &inv_table, &src_range, &table,
+                               &dst_range, &brightness, &contrast,
+                               &saturation) >= 0) {
+    sws_setColorspaceDetails(context, inv_table, src_range, table, 1,
+                             brightness, contrast, saturation);
+  }
+}
+} // namespace
+
+SliceScaler::~SliceScaler() { reset(); }
+
+bool SliceScaler::init(int src_width, int src_height, AVPixelFormat src_format,
+                       int dst_width, int dst_height, AVPixelFormat dst_format,
+                       int slices, bool full_range) {
+  reset();
+  if (slices <= 0) {
+    slices = std::min<int>(kMaxAutoSlices,
+                           std::max(1u, std::thread::hardware_concurrency()));
+  }
+  slices = std::max(
+      1, std::min(slices, std::min(src_height, dst_height) / kMinBandRows));
+
+  for (int i = 0; i < slices; ++i) {
+    Band band{};
+    band.dst_y = align_rows(dst_height * i / slices);
+    int dst_end =
+        i + 1 == slices ? dst_height : align_rows(dst_height * (i + 1) / slices);
+    band.dst_height = dst_end - band.dst_y;
+    // 源行范围按缩放比例对应，同样按 2 行对齐
+    band.src_y = align_rows(static_cast<int>(
+        static_cast<int64_t>(band.dst_y) * src_height / dst_height));
+    int src_end = i + 1 == slices
+                      ? src_height
+                      : align_rows(static_cast<int>(
+                            static_cast<int64_t>(dst_end) * src_height /
+                            dst_height));
+    band.src_height = src_end - band.src_y;
+
+    band.context = sws_getContext(src_width, band.src_height, src_format,
+                                  dst_width, band.dst_height, dst_format,
+                                  SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!band.context) {
+      reset();
+      return false;
+    }
+    if (full_range) {
+      set_full_range_output(band.context);
+    }
+    bands_.push_back(band);
+  }
+
+  src_width_ = src_width;
+  src_height_ = src_height;
+  src_format_ = src_format;
+  dst_format_ = dst_format;
+  std::cout << "Scaler " << src_width << "x" << src_height << " -> "
+            << dst_width << "x" << dst_height << " using " << bands_.size()
+            << " slice(s)" << std::endl;
+  return true;
+}
+
+void SliceScaler::reset() {
+  for (Band &band : bands_) {
+    sws_freeContext(band.context);
+  }
+  bands_.clear();
+  src_width_ = 0;
+  src_height_ = 0;
+  src_format_ = AV_PIX_FMT_NONE;
+  dst_format_ = AV_PIX_FMT_NONE;
+}
+
+void SliceScaler::swap(SliceScaler &other) {
+  std::swap(bands_, other.bands_);
+  std::swap(src_width_, other.src_width_);
+  std::swap(src_height_, other.src_height_);
+  std::swap(src_format_, other.src_format_);
+  std::swap(dst_format_, other.dst_format_);
+}
+
+bool SliceScaler::matches(int src_width, int src_height,
+                          AVPixelFormat src_format) const {
+  return is_initialized() && src_width == src_width_ &&
+         src_height == src_height_ && src_format == src_format_;
+}
+
+void SliceScaler::scale_band(const Band &band, const AVFrame *src,
+                             AVFrame *dst) const {
+  const AVPixFmtDescriptor *src_desc = av_pix_fmt_desc_get(src_format_);
+  const AVPixFmtDescriptor *dst_desc = av_pix_fmt_desc_get(dst_format_);
+  const uint8_t *src_data[AV_NUM_DATA_POINTERS] = {};
+  uint8_t *dst_data[AV_NUM_DATA_POINTERS] = {};
+  for (int plane = 0; plane < av_pix_fmt_count_planes(src_format_); ++plane) {
+    src_data[plane] = src->data[plane] +
+                      plane_row(src_desc, plane, band.src_y) * src->linesize[plane];
+  }
+  for (int plane = 0; plane < av_pix_fmt_count_planes(dst_format_); ++plane) {
+    dst_data[plane] = dst->data[plane] +
+                      plane_row(dst_desc, plane, band.dst_y) * dst->linesize[plane];
+  }
+  sws_scale(band.context, src_data, src->linesize, 0, band.src_height,
+            dst_data, dst->linesize);
+}
+
+void SliceScaler::scale(const AVFrame *src, AVFrame *dst) {
+  if (bands_.size() == 1) {
+    scale_band(bands_[0], src, dst);
+    return;
+  }
+  // 缩放在视频解码任务内进行，条带沿用视频的普通优先级
+  Executor::shared().parallel_for(
+      TaskPriority::Normal, bands_.size(),
+      [&](size_t index) { scale_band(bands_[index], src, dst); });
+}
@@ -0,0 +1,531 @@
+#include "v4l2_source.h"
+#include "h264_nal.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+extern "C" {
+#include <libavutil/buffer.h>
+#include <libavutil/imgutils.h>
+}
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// 错误处理函数替代 av_err2str
+extern std::string av_error_string(int errnum);
+
+#ifdef __linux__
+
+namespace {
+
+// 驱动缓冲区个数：解码队列 Mailbox 深度 + 正在解码/缩放的帧 + 驱动正在填充的帧，
+// 再留出余量，避免下游持有缓冲区时驱动无处写入而丢帧
+constexpr unsigned int kBufferCount = 6;
+// 驱动中至少保留的空缓冲区个数，低于该值时改为拷贝并立即归还
+constexpr int kMinQueuedBuffers = 2;
+
+struct FormatEntry {
+  const char *name;
+  uint32_t fourcc;
+  AVCodecID codec_id;
+  AVPixelFormat pix_fmt;
+};
+
+const FormatEntry kFormats[] = {
+    {"mjpeg", V4L2_PIX_FMT_MJPEG, AV_CODEC_ID_MJPEG, AV_PIX_FMT_NONE},
+    {"yuyv422", V4L2_PIX_FMT_YUYV, AV_CODEC_ID_RAWVIDEO, AV_PIX_FMT_YUYV422},
+    {"nv12", V4L2_PIX_FMT_NV12, AV_CODEC_ID_RAWVIDEO, AV_PIX_FMT_NV12},
+    {"yuv420p", V4L2_PIX_FMT_YUV420, AV_CODEC_ID_RAWVIDEO, AV_PIX_FMT_YUV420P},
+    {"h264", V4L2_PIX_FMT_H264, AV_CODEC_ID_H264, AV_PIX_FMT_NONE},
+};
+
+int xioctl(int fd, unsigned long request, void *arg) {
+  int ret;
+  do {
+    ret = ioctl(fd, request, arg);
+  } while (ret < 0 && errno == EINTR);
+  return ret;
+}
+
+std::string fourcc_string(uint32_t fourcc) {
+  std::string s(4, ' ');
+  for (int i = 0; i < 4; ++i) {
+    s[i] = static_cast<char>((fourcc >> (8 * i)) & 0xff);
+  }
+  return s;
+}
+
+} // namespace
+
+// mmap 缓冲区及设备句柄。V4L2Source 和每个尚未释放的 AVPacket 各持有一个引用，
+// 最后一个引用释放时才解除映射并关闭设备，因此 close() 之后队列里残留的包仍然有效
+struct V4L2Source::BufferPool {
+  struct Buffer {
+    BufferPool *pool = nullptr;
+    uint32_t index = 0;
+    void *start = MAP_FAILED;
+    size_t length = 0;
+    bool held = false; // 被零拷贝的 AVPacket 引用，尚未归还
+  };
+
+  int fd = -1;
+  std::vector<Buffer> buffers;
+  std::mutex mutex;
+  bool streaming = false;
+  std::atomic<int> queued{0};
+  std::atomic<int> refs{1};
+
+  ~BufferPool() {
+    for (auto &buffer : buffers) {
+      if (buffer.start != MAP_FAILED) {
+        munmap(buffer.start, buffer.length);
+      }
+    }
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+
+  bool queue_buffer(uint32_t index) {
+    v4l2_buffer buf{};
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = index;
+    if (xioctl(fd, VIDIOC_QBUF, &buf) < 0) {
+      return false;
+    }
+    queued.fetch_add(1);
+    return true;
+  }
+
+  void requeue(uint32_t index) {
+    std::lock_guard<std::mutex> lock(mutex);
+    buffers[index].held = false;
+    // 停止采集期间归还的缓冲区在重新开流时再入队
+    if (streaming && !queue_buffer(index)) {
+      std::cerr << "V4L2: failed to requeue buffer " << index << ": "
+                << strerror(errno) << std::endl;
+    }
+  }
+
+  void release() {
+    if (refs.fetch_sub(1) == 1) {
+      delete this;
+    }
+  }
+};
+
+V4L2Source::V4L2Source(bool debug_enabled) : debug_enabled_(debug_enabled) {}
+
+V4L2Source::~V4L2Source() { close(); }
+
+bool V4L2Source::open(const std::string &device, int width, int height,
+                      int fps, const std::string &format) {
+  close();
+
+  const FormatEntry *entry = nullptr;
+  for (const auto &candidate : kFormats) {
+    if (format == candidate.name) {
+      entry = &candidate;
+      break;
+    }
+  }
+  if (!entry) {
+    std::cerr << "V4L2: unsupported input format " << format << std::endl;
+    return false;
+  }
+
+  int fd = ::open(device.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+    std::cerr << "V4L2: cannot open " << device << ": " << strerror(errno)
+              << std::endl;
+    return false;
+  }
+  auto pool = new BufferPool();
+  pool->fd = fd;
+  auto fail = [&](const char *what) {
+    std::cerr << "V4L2: " << what << " failed on " << device << ": "
+              << strerror(errno) << std::endl;
+    pool->release();
+    return false;
+  };
+
+  v4l2_capability cap{};
+  if (xioctl(fd, VIDIOC_QUERYCAP, &cap) < 0) {
+    return fail("VIDIOC_QUERYCAP");
+  }
+  uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps
+                                                            : cap.capabilities;
+  if (!(caps & V4L2_CAP_VIDEO_CAPTURE) || !(caps & V4L2_CAP_STREAMING)) {
+    std::cerr << "V4L2: " << device
+              << " is not a streaming video capture device" << std::endl;
+    pool->release();
+    return false;
+  }
+
+  v4l2_format fmt{};
+  fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  fmt.fmt.pix.width = width;
+  fmt.fmt.pix.height = height;
+  fmt.fmt.pix.pixelformat = entry->fourcc;
+  fmt.fmt.pix.field = V4L2_FIELD_ANY;
+  if (xioctl(fd, VIDIOC_S_FMT, &fmt) < 0) {
+    return fail("VIDIOC_S_FMT");
+  }
+  uint32_t pixelformat = fmt.fmt.pix.pixelformat;
+  // 部分 UVC 驱动把 MJPEG 报告为 JPEG
+  bool jpeg_alias = entry->codec_id == AV_CODEC_ID_MJPEG &&
+                    pixelformat == V4L2_PIX_FMT_JPEG;
+  if (pixelformat != entry->fourcc && !jpeg_alias) {
+    std::cerr << "V4L2: driver selected " << fourcc_string(pixelformat)
+              << " instead of " << format << std::endl;
+    pool->release();
+    return false;
+  }
+  width = fmt.fmt.pix.width;
+  height = fmt.fmt.pix.height;
+
+  // rawvideo 解码器按紧密排列的帧解析，行跨度带填充的驱动交给 libavdevice 处理
+  if (entry->codec_id == AV_CODEC_ID_RAWVIDEO) {
+    int expected = av_image_get_buffer_size(entry->pix_fmt, width, height, 1);
+    int linesize = av_image_get_linesize(entry->pix_fmt, width, 0);
+    if (expected <= 0 ||
+        fmt.fmt.pix.sizeimage < static_cast<uint32_t>(expected) ||
+        fmt.fmt.pix.bytesperline != static_cast<uint32_t>(linesize)) {
+      std::cerr << "V4L2: unexpected frame layout (bytesperline="
+                << fmt.fmt.pix.bytesperline
+                << ", sizeimage=" << fmt.fmt.pix.sizeimage << ")"
+                << std::endl;
+      pool->release();
+      return false;
+    }
+  }
+
+  v4l2_streamparm parm{};
+  parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  parm.parm.capture.timeperframe.numerator = 1;
+  parm.parm.capture.timeperframe.denominator = fps;
+  if (xioctl(fd, VIDIOC_S_PARM, &parm) < 0) {
+    // 部分驱动不支持设置帧率，沿用驱动默认值
+    std::cerr << "V4L2: VIDIOC_S_PARM failed: " << strerror(errno)
+              << std::endl;
+  }
+  const v4l2_fract &tpf = parm.parm.capture.timeperframe;
+  frame_rate_ = (tpf.numerator && tpf.denominator)
+                    ? AVRational{static_cast<int>(tpf.denominator),
+                                 static_cast<int>(tpf.numerator)}
+                    : AVRational{fps, 1};
+
+  v4l2_requestbuffers req{};
+  req.count = kBufferCount;
+  req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  req.memory = V4L2_MEMORY_MMAP;
+  if (xioctl(fd, VIDIOC_REQBUFS, &req) < 0) {
+    return fail("VIDIOC_REQBUFS");
+  }
+  if (req.count < 2) {
+    std::cerr << "V4L2: driver granted only " << req.count << " buffers"
+              << std::endl;
+    pool->release();
+    return false;
+  }
+
+  pool->buffers.resize(req.count);
+  for (uint32_t i = 0; i < req.count; ++i) {
+    v4l2_buffer buf{};
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = i;
+    if (xioctl(fd, VIDIOC_QUERYBUF, &buf) < 0) {
+      return fail("VIDIOC_QUERYBUF");
+    }
+    BufferPool::Buffer &buffer = pool->buffers[i];
+    buffer.pool = pool;
+    buffer.index = i;
+    buffer.length = buf.length;
+    buffer.start = mmap(nullptr, buf.length, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, fd, buf.m.offset);
+    if (buffer.start == MAP_FAILED) {
+      return fail("mmap");
+    }
+    if (!pool->queue_buffer(i)) {
+      return fail("VIDIOC_QBUF");
+    }
+  }
+
+  v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  if (xioctl(fd, VIDIOC_STREAMON, &type) < 0) {
+    return fail("VIDIOC_STREAMON");
+  }
+  pool->streaming = true;
+  pool_ = pool;
+
+  codecpar_ = avcodec_parameters_alloc();
+  codecpar_->codec_type = AVMEDIA_TYPE_VIDEO;
+  codecpar_->codec_id = entry->codec_id;
+  codecpar_->format = entry->pix_fmt;
+  codecpar_->width = width;
+  codecpar_->height = height;
+  needs_padding_ = entry->codec_id != AV_CODEC_ID_RAWVIDEO;
+  is_h264_ = entry->codec_id == AV_CODEC_ID_H264;
+  intra_only_ = !is_h264_;
+  has_bitrate_control_ =
+      is_h264_ && query_control(V4L2_CID_MPEG_VIDEO_BITRATE);
+  has_keyframe_control_ =
+      is_h264_ && query_control(V4L2_CID_MPEG_VIDEO_FORCE_KEY_FRAME);
+  if (is_h264_ && (!has_bitrate_control_ || !has_keyframe_control_)) {
+    // 主线 uvcvideo 不映射 MPEG 编码控制项，只打印一次
+    std::cerr << "V4L2: " << device << " lacks "
+              << (has_keyframe_control_ ? "" : "FORCE_KEY_FRAME ")
+              << (has_bitrate_control_ ? "" : "VIDEO_BITRATE ")
+              << "controls, the camera's own GOP and bitrate are used"
+              << std::endl;
+  }
+
+  std::cout << "V4L2 native capture: " << device << " "
+            << fourcc_string(pixelformat) << " " << width << "x" << height
+            << " @ " << frame_rate_.num << "/" << frame_rate_.den << " fps, "
+            << req.count << " mmap buffers" << std::endl;
+  return true;
+}
+
+void V4L2Source::close() {
+  if (pool_) {
+    {
+      std::lock_guard<std::mutex> lock(pool_->mutex);
+      if (pool_->streaming) {
+        v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        xioctl(pool_->fd, VIDIOC_STREAMOFF, &type);
+        pool_->streaming = false;
+      }
+    }
+    pool_->release();
+    pool_ = nullptr;
+  }
+  if (codecpar_) {
+    avcodec_parameters_free(&codecpar_);
+  }
+}
+
+bool V4L2Source::stop_streaming() {
+  if (!pool_) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(pool_->mutex);
+  if (!pool_->streaming) {
+    return true;
+  }
+  // STREAMOFF 同时把驱动中的缓冲区全部出队，积压的旧帧随之丢弃
+  v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  if (xioctl(pool_->fd, VIDIOC_STREAMOFF, &type) < 0) {
+    std::cerr << "V4L2: VIDIOC_STREAMOFF failed: " << strerror(errno)
+              << std::endl;
+    return false;
+  }
+  pool_->streaming = false;
+  pool_->queued = 0;
+  return true;
+}
+
+bool V4L2Source::start_streaming() {
+  if (!pool_) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(pool_->mutex);
+  if (pool_->streaming) {
+    return true;
+  }
+  // 仍被下游包引用的缓冲区在释放时由 requeue 入队
+  for (const auto &buffer : pool_->buffers) {
+    if (!buffer.held && !pool_->queue_buffer(buffer.index)) {
+      std::cerr << "V4L2: VIDIOC_QBUF failed: " << strerror(errno)
+                << std::endl;
+      return false;
+    }
+  }
+  v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  if (xioctl(pool_->fd, VIDIOC_STREAMON, &type) < 0) {
+    std::cerr << "V4L2: VIDIOC_STREAMON failed: " << strerror(errno)
+              << std::endl;
+    return false;
+  }
+  pool_->streaming = true;
+  return true;
+}
+
+int V4L2Source::read_packet(AVPacket *packet, int timeout_ms) {
+  if (!pool_) {
+    return AVERROR(EINVAL);
+  }
+
+  pollfd pfd{};
+  pfd.fd = pool_->fd;
+  pfd.events = POLLIN;
+  int ret = poll(&pfd, 1, timeout_ms);
+  if (ret == 0 || (ret < 0 && errno == EINTR)) {
+    return AVERROR(EAGAIN);
+  }
+  if (ret < 0) {
+    return AVERROR(errno);
+  }
+  if (pfd.revents & (POLLERR | POLLHUP)) {
+    return AVERROR(EIO);
+  }
+
+  v4l2_buffer buf{};
+  buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  buf.memory = V4L2_MEMORY_MMAP;
+  if (xioctl(pool_->fd, VIDIOC_DQBUF, &buf) < 0) {
+    return errno == EAGAIN ? AVERROR(EAGAIN) : AVERROR(errno);
+  }
+  pool_->queued.fetch_sub(1);
+
+  BufferPool::Buffer &buffer = pool_->buffers[buf.index];
+  if ((buf.flags & V4L2_BUF_FLAG_ERROR) || buf.bytesused == 0) {
+    // 损坏的帧直接归还驱动
+    pool_->requeue(buf.index);
+    return AVERROR(EAGAIN);
+  }
+
+  av_packet_unref(packet);
+  size_t size = buf.bytesused;
+  bool has_padding = !needs_padding_ ||
+                     size + AV_INPUT_BUFFER_PADDING_SIZE <= buffer.length;
+  if (has_padding && pool_->queued.load() >= kMinQueuedBuffers) {
+    // 零拷贝：packet 直接引用 mmap 缓冲区，释放时重新入队
+    pool_->refs.fetch_add(1);
+    AVBufferRef *ref =
+        av_buffer_create(static_cast<uint8_t *>(buffer.start), size,
+                         &V4L2Source::release_buffer, &buffer, 0);
+    if (!ref) {
+      pool_->refs.fetch_sub(1);
+      pool_->requeue(buf.index);
+      return AVERROR(ENOMEM);
+    }
+    {
+      std::lock_guard<std::mutex> lock(pool_->mutex);
+      buffer.held = true;
+    }
+    packet->buf = ref;
+    packet->data = ref->data;
+    packet->size = static_cast<int>(size);
+  } else {
+    // 下游占用了太多缓冲区或缺少尾部填充：拷贝后立即归还，避免驱动无缓冲区可写
+    ret = av_new_packet(packet, static_cast<int>(size));
+    if (ret == 0) {
+      memcpy(packet->data, buffer.start, size);
+    }
+    pool_->requeue(buf.index);
+    if (ret < 0) {
+      return ret;
+    }
+    if (debug_enabled_) {
+      std::cout << "V4L2: copied frame (queued buffers: "
+                << pool_->queued.load() << ")" << std::endl;
+    }
+  }
+
+  packet->stream_index = 0;
+  packet->pts = packet->dts =
+      static_cast<int64_t>(buf.timestamp.tv_sec) * 1000000 +
+      buf.timestamp.tv_usec;
+  // UVC 驱动通常不设置 V4L2_BUF_FLAG_KEYFRAME，H.264 需要自己识别 IDR
+  if (intra_only_ || (buf.flags & V4L2_BUF_FLAG_KEYFRAME) ||
+      (is_h264_ && h264_has_idr(packet->data, packet->size))) {
+    packet->flags |= AV_PKT_FLAG_KEY;
+  }
+  return 0;
+}
+
+bool V4L2Source::set_bitrate(int bit_rate) {
+  if (!has_bitrate_control_) {
+    return false;
+  }
+  return set_control(V4L2_CID_MPEG_VIDEO_BITRATE, bit_rate, "bitrate");
+}
+
+bool V4L2Source::request_keyframe() {
+  if (!has_keyframe_control_) {
+    return false;
+  }
+  return set_control(V4L2_CID_MPEG_VIDEO_FORCE_KEY_FRAME, 1,
+                     "force key frame");
+}
+
+bool V4L2Source::set_control(uint32_t id, int32_t value, const char *name) {
+  if (!pool_) {
+    return false;
+  }
+  v4l2_control ctrl{};
+  ctrl.id = id;
+  ctrl.value = value;
+  if (xioctl(pool_->fd, VIDIOC_S_CTRL, &ctrl) < 0) {
+    if (debug_enabled_) {
+      std::cerr << "V4L2: cannot set " << name << " control: "
+                << strerror(errno) << std::endl;
+    }
+    return false;
+  }
+  return true;
+}
+
+bool V4L2Source::query_control(uint32_t id) const {
+  if (!pool_) {
+    return false;
+  }
+  v4l2_queryctrl query{};
+  query.id = id;
+  return xioctl(pool_->fd, VIDIOC_QUERYCTRL, &query) == 0 &&
+         !(query.flags & V4L2_CTRL_FLAG_DISABLED);
+}
+
+void V4L2Source::release_buffer(void *opaque, uint8_t *data) {
+  auto buffer = static_cast<BufferPool::Buffer *>(opaque);
+  BufferPool *pool = buffer->pool;
+  pool->requeue(buffer->index);
+  pool->release();
+}
+
+#else // !__linux__
+
+struct V4L2Source::BufferPool {};
+
+V4L2Source::V4L2Source(bool debug_enabled) : debug_enabled_(debug_enabled) {}
+
+V4L2Source::~V4L2Source() { close(); }
+
+bool V4L2Source::open(const std::string &, int, int, int,
+                      const std::string &) {
+  // 非 Linux 系统没有 V4L2，由调用方回退到 libavdevice
+  return false;
+}
+
+void V4L2Source::close() {}
+
+bool V4L2Source::stop_streaming() { return false; }
+
+bool V4L2Source::start_streaming() { return false; }
+
+int V4L2Source::read_packet(AVPacket *, int) { return AVERROR(ENOSYS); }
+
+bool V4L2Source::set_bitrate(int) { return false; }
+
+bool V4L2Source::request_keyframe() { return false; }
+
+bool V4L2Source::set_control(uint32_t, int32_t, const char *) { return false; }
+
+bool V4L2Source::query_control(uint32_t) const { return false; }
+
+void V4L2Source::release_buffer(void *, uint8_t *) {}
+
+#endif // __linux__
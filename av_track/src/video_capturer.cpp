@@ -1,8 +1,9 @@
 #include "video_capturer.h"
+#include "codec_threads.h"
 #include "debug_utils.h"
 #include "encoder.h"
-#include "h264_encoder.h"
-#include "h265_encoder.h"
+#include "encoder_factory.h"
+#include "pixel_convert.h"
 #include <algorithm>
 #include <chrono>
 #include <cstring>
@@ -27,6 +28,9 @@ std::string av_error_string(int errnum) {
   return std::string(errbuf);
 }
 
+// 实时画面优先：解码/编码队列只保留最新的几帧，积压时丢弃旧帧而不是清空所有队列
+constexpr size_t kVideoMailboxDepth = 2;
+
 VideoCapturer::VideoCapturer(const std::string &device, bool debug_enabled,
                              const std::string &resolution, int framerate,
                              const std::string &video_format,
@@ -42,6 +46,12 @@ VideoCapturer::VideoCapturer(const std::string &device, bool debug_enabled,
   is_udp_stream_ = (device_.substr(0, 6) == "udp://" ||
                     device_.substr(0, 7) == "rtsp://" ||
                     device_.find(".sdp") != std::string::npos);
+
+  // Mailbox 需要生产者丢弃最旧的帧，两个队列会由 Spsc 退回 Locked 后端
+  decode_queue_.set_overflow_policy(OverflowPolicy::Mailbox, kVideoMailboxDepth);
+  encode_queue_.set_overflow_policy(OverflowPolicy::Mailbox, kVideoMailboxDepth);
+  // 发送队列中是已编码的包，满时由 push_gop_aware 丢弃到下一个关键帧
+  send_queue_.set_overflow_policy(OverflowPolicy::Reject);
 }
 
 VideoCapturer::~VideoCapturer() { stop(); }
@@ -50,8 +60,8 @@ VideoCapturer::~VideoCapturer() { stop(); }
 // void VideoCapturer::set_track_callback(TrackCallback callback)
 
 bool VideoCapturer::start() {
-  AVInputFormat *input_format = nullptr;
   std::string device_path = device_;
+  begin_startup_timing("start");
 
   if (is_udp_stream_) {
     // 网络流模式（UDP/RTSP/SDP）：直接接收H.264编码的视频流
@@ -97,204 +107,160 @@ bool VideoCapturer::start() {
       std::cerr << "Stream URL: " << device_path << std::endl;
       return false;
     }
-  } else {
-    // 普通摄像头模式
-    input_format = av_find_input_format("v4l2");
-    if (!input_format) {
-      std::cerr << "Cannot find V4L2 input input_format" << std::endl;
-      return false;
-    }
-
-    // Parse resolution
-    int width = 640, height = 480; // Default values
-    sscanf(resolution_.c_str(), "%dx%d", &width, &height);
-    std::cout << "Resolution: " << width << "x" << height << std::endl;
-    if (width < height) {
-      resolution_ = std::to_string(height) + "x" + std::to_string(width);
-    }
 
-    AVDictionary *options = nullptr;
-    av_dict_set(&options, "video_size", resolution_.c_str(), 0);
-    av_dict_set(&options, "framerate", std::to_string(framerate_).c_str(), 0);
-    av_dict_set(&options, "input_format", video_format_.c_str(),
-                0); // 使用视频输入格式参数
-    // 移除 pixel_format 设置，让 ffmpeg 自动检测
-    std::cout << "Using video input format: " << video_format_ << std::endl;
-    int ret = avformat_open_input(&format_context_, device_path.c_str(),
-                                  input_format, &options);
-    if (ret < 0) {
-      std::cerr << "Cannot open video device: " << av_error_string(ret)
-                << std::endl;
+    if (!find_video_stream()) {
       return false;
     }
-  }
-
-  int ret = avformat_find_stream_info(format_context_, nullptr);
-  if (ret < 0) {
-    std::cerr << "Cannot find stream info: " << av_error_string(ret)
-              << std::endl;
-    if (is_udp_stream_) {
-      std::cerr << "Network stream may not be transmitting or connection failed" << std::endl;
+    log_startup_phase(StartupPhase::DeviceOpen);
+  } else {
+    // 普通摄像头模式
+    if (camera_passthrough_) {
+      // 直通模式：摄像头直接输出 H.264，不解码也不重新编码
+      if (video_codec_ != "h264") {
+        std::cerr << "Camera passthrough requires h264 codec, got: "
+                  << video_codec_ << std::endl;
+        return false;
+      }
+      video_format_ = "h264";
     }
-    return false;
-  }
-
-  video_stream_index_ = -1;
-  for (unsigned int i = 0; i < format_context_->nb_streams; i++) {
-    if (format_context_->streams[i]->codecpar->codec_type ==
-        AVMEDIA_TYPE_VIDEO) {
-      video_stream_index_ = i;
-      break;
+    if (!open_camera_input()) {
+      return false;
     }
-  }
-
-  if (video_stream_index_ == -1) {
-    std::cerr << "Cannot find video stream" << std::endl;
-    return false;
+    log_startup_phase(StartupPhase::DeviceOpen);
   }
 
   if (is_udp_stream_) {
-    // UDP流模式：验证视频编码是否为H.264或H.265
+    // UDP流模式：验证视频编码与请求的编码一致
     AVCodecParameters *codec_params =
         format_context_->streams[video_stream_index_]->codecpar;
 
-    if (video_codec_ == "h264") {
-      if (codec_params->codec_id != AV_CODEC_ID_H264) {
-        std::cerr << "UDP stream codec is not H.264 (codec_id: " << codec_params->codec_id << ")" << std::endl;
-        std::cerr << "Requested codec: h264" << std::endl;
-        return false;
-      }
-      std::cout << "UDP stream is H.264 encoded, ready for direct forwarding" << std::endl;
-    } else if (video_codec_ == "h265") {
-      if (codec_params->codec_id != AV_CODEC_ID_H265) {
-        std::cerr << "UDP stream codec is not H.265 (codec_id: " << codec_params->codec_id << ")" << std::endl;
-        std::cerr << "Requested codec: h265" << std::endl;
-        return false;
-      }
-      std::cout << "UDP stream is H.265 encoded, ready for direct forwarding" << std::endl;
-    } else {
+    const VideoCodecInfo *codec_info = find_video_codec(video_codec_);
+    if (!codec_info) {
       std::cerr << "Unknown video codec: " << video_codec_ << std::endl;
       return false;
     }
-  } else {
-    // 普通摄像头模式：需要解码和编码
-    AVCodecParameters *codec_params =
-        format_context_->streams[video_stream_index_]->codecpar;
-    const AVCodec *codec = avcodec_find_decoder(codec_params->codec_id);
-    if (!codec) {
-      std::cerr << "Cannot find decoder" << std::endl;
+    if (codec_params->codec_id != codec_info->codec_id) {
+      std::cerr << "UDP stream codec is not " << codec_info->display_name
+                << " (codec_id: " << codec_params->codec_id << ")" << std::endl;
+      std::cerr << "Requested codec: " << video_codec_ << std::endl;
       return false;
     }
-
-    codec_context_ = avcodec_alloc_context3(codec);
-    avcodec_parameters_to_context(codec_context_, codec_params);
-
-    ret = avcodec_open2(codec_context_, codec, nullptr);
-    if (ret < 0) {
-      std::cerr << "Cannot open codec: " << av_error_string(ret) << std::endl;
+    std::cout << "UDP stream is " << codec_info->display_name
+              << " encoded, ready for direct forwarding" << std::endl;
+  } else if (camera_passthrough_) {
+    if (input_codec_parameters()->codec_id != AV_CODEC_ID_H264) {
+      std::cerr << "Camera does not output H.264, cannot use passthrough"
+                << std::endl;
       return false;
     }
+    std::cout << "Camera passthrough: forwarding H.264 from " << device_
+              << " without re-encoding" << std::endl;
+    if (!v4l2_source_) {
+      std::cout << "Camera passthrough without native V4L2: bitrate and "
+                   "keyframe controls unavailable"
+                << std::endl;
+    }
+    if (rotation_ != 0 || mirror_) {
+      std::cout << "Rotation is not applied in camera passthrough mode"
+                << std::endl;
+    }
+  } else {
+    // 普通摄像头模式：需要解码和编码
+    int width = 640, height = 480;
+    output_size(width, height);
 
-    // 设置4个线程用于解码
-    codec_context_->thread_count = 2;
+    if (!open_decoder(width, height)) {
+      return false;
+    }
+    update_input_policy();
 
-    std::cout << "Capturer Decoder Using " << codec_context_->thread_count << " threads"
+    std::cout << "Capturer Decoder Using " << codec_context_->thread_count
+              << " " << codec_thread_type_name(codec_context_->thread_type)
+              << " threads" << std::endl;
+    std::cout << "Pixel conversion kernels: " << fast_convert_kernel_name()
               << std::endl;
 
-    // Parse resolution
-    int width = 640, height = 480;
-    sscanf(resolution_.c_str(), "%dx%d", &width, &height);
-
     // 根据视频编码器类型创建编码器
-    if (video_codec_ == "h264") {
-      encoder_ = std::make_unique<H264Encoder>(debug_enabled_);
-      std::cout << "Using H.264 encoder" << std::endl;
-    } else if (video_codec_ == "h265") {
-      encoder_ = std::make_unique<H265Encoder>(debug_enabled_);
-      std::cout << "Using H.265 encoder" << std::endl;
-    } else {
+    if (!find_video_codec(video_codec_)) {
       std::cerr << "Unknown video codec: " << video_codec_ << ", falling back to H.264" << std::endl;
-      encoder_ = std::make_unique<H264Encoder>(debug_enabled_);
       video_codec_ = "h264";
     }
+    encoder_ = make_encoder();
+    std::cout << "Using " << find_video_codec(video_codec_)->display_name
+              << " encoder" << std::endl;
 
-    // Initialize encoder
+    // Initialize encoder，旋转 90/270 度时按旋转后的宽高编码
+    if (rotation_swaps_dimensions(rotation_)) {
+      std::swap(width, height);
+    }
+    encoder_->set_full_range(input_full_range());
     if (!encoder_->open_encoder(width, height, framerate_, 0)) {
       std::cerr << "Cannot open " << video_codec_ << " encoder" << std::endl;
       return false;
     }
-    AVCodecContext *encoder_context = encoder_->get_context();
-    encoder_out_width_ = encoder_context->width;
-    encoder_out_height_ = encoder_context->height;
-    encoder_out_pix_fmt_ = encoder_context->pix_fmt;
-    sws_context_ = sws_getContext(
-        codec_context_->width, codec_context_->height, codec_context_->pix_fmt,
-        encoder_out_width_, encoder_out_height_, encoder_out_pix_fmt_,
-        SWS_BILINEAR, nullptr, nullptr, nullptr);
-
-    if (!sws_context_) {
+    encode_fps_ = framerate_;
+    update_output_geometry(*encoder_);
+    if (!create_scaler(codec_context_->width, codec_context_->height,
+                       codec_context_->pix_fmt)) {
       std::cerr << "Cannot create SwsContext" << std::endl;
       return false;
     }
   }
 
   is_running_ = true;
-  // 等待 track_callback_ 设置后再启动采集线程
-  capture_thread_ = std::thread(&VideoCapturer::capture_loop, this);
-
+  decoded_frame_ = make_av_frame();
+  encode_packet_ = make_av_packet();
+  send_dropping_until_keyframe_ = false;
+  parameter_sets_.clear();
+  reset_parameter_sets_ = false;
+
+  // 解码/编码/发送作为任务运行在共享线程池上，视频使用普通优先级，
+  // 与音频同时工作时让音频先执行
   if (is_udp_stream_) {
-    // 网络流模式（UDP/RTSP/SDP）：只启动采集和发送线程
+    // 网络流模式（UDP/RTSP/SDP）：只有采集线程和发送任务
     bool is_rtsp = (device_.substr(0, 7) == "rtsp://");
     bool is_sdp = (device_.find(".sdp") != std::string::npos);
 
     if (is_rtsp) {
-      std::cout << "RTSP stream mode: Starting capture and send threads only" << std::endl;
+      std::cout << "RTSP stream mode: Starting capture and send only" << std::endl;
     } else if (is_sdp) {
-      std::cout << "SDP file mode: Starting capture and send threads only" << std::endl;
-    } else {
-      std::cout << "UDP stream mode: Starting capture and send threads only" << std::endl;
-    }
-    send_thread_ = std::thread(&VideoCapturer::send_loop, this);
-
-    // 如果CPU数量大于等于2，则绑定线程到不同的CPU
-    int cpu_count = get_cpu_count();
-    if (cpu_count >= 2) {
-      std::cout << "Detected " << cpu_count << " CPUs, binding threads to different CPUs" << std::endl;
-      bind_thread_to_cpu(capture_thread_, 0); // 采集线程绑定到CPU 0
-      bind_thread_to_cpu(send_thread_, 1);    // 发送线程绑定到CPU 1
+      std::cout << "SDP file mode: Starting capture and send only" << std::endl;
     } else {
-      std::cout << "CPU count: " << cpu_count << ", skipping CPU binding" << std::endl;
+      std::cout << "UDP stream mode: Starting capture and send only" << std::endl;
     }
+    start_stages(TaskPriority::Normal, {PipelineStage::Send});
+  } else if (camera_passthrough_) {
+    std::cout << "Camera passthrough mode: Starting capture and send only"
+              << std::endl;
+    start_stages(TaskPriority::Normal, {PipelineStage::Send});
+  } else if (fused_pipeline_) {
+    // fused 模式下编码在解码任务内完成
+    std::cout << "Fused pipeline: decode, scale and encode in one task"
+              << std::endl;
+    start_stages(TaskPriority::Normal,
+                 {PipelineStage::Decode, PipelineStage::Send});
   } else {
-    // 普通摄像头模式：启动所有线程
-    decode_thread_ = std::thread(&VideoCapturer::decode_loop, this);
-    encode_thread_ = std::thread(&VideoCapturer::encode_loop, this);
-    send_thread_ = std::thread(&VideoCapturer::send_loop, this);
-
-    // 如果CPU数量大于等于4，则绑定线程到不同的CPU
-    int cpu_count = get_cpu_count();
-    if (cpu_count >= 4) {
-      std::cout << "Detected " << cpu_count << " CPUs, binding threads to different CPUs" << std::endl;
-      bind_thread_to_cpu(capture_thread_, 0); // 采集线程绑定到CPU 0
-      //    bind_thread_to_cpu(decode_thread_, 3);  // 解码线程绑定到CPU 3
-      //    bind_thread_to_cpu(encode_thread_, 1);  // 编码线程绑定到CPU 1
-      bind_thread_to_cpu(send_thread_, 2);    // 发送线程绑定到CPU 2
-    } else {
-      std::cout << "CPU count: " << cpu_count << ", skipping CPU binding" << std::endl;
-    }
+    start_stages(TaskPriority::Normal, {PipelineStage::Decode,
+                                        PipelineStage::Encode,
+                                        PipelineStage::Send});
   }
 
+  // 等待 track_callback_ 设置后再启动采集线程
+  capture_thread_ = std::thread(&VideoCapturer::capture_loop, this);
+
+  start_queue_stats("Video");
   std::cout << "Video capture started successfully" << std::endl;
   return true;
 }
 
 void VideoCapturer::stop() {
   Capture::stop();
+  decoded_frame_.reset();
+  encode_packet_.reset();
+  send_batch_.clear();
+  rotate_scratch_.reset();
 
-  if (sws_context_) {
-    sws_freeContext(sws_context_);
-    sws_context_ = nullptr;
-  }
+  scaler_.reset();
 
   clear_frame_pool();
 
@@ -307,6 +273,312 @@ void VideoCapturer::stop() {
     avformat_close_input(&format_context_);
     format_context_ = nullptr;
   }
+
+  // 队列中残留的零拷贝包持有缓冲区引用，最后一个释放时才真正解除映射
+  v4l2_source_.reset();
+}
+
+bool VideoCapturer::find_video_stream(bool probe) {
+  if (probe) {
+    int ret = avformat_find_stream_info(format_context_, nullptr);
+    if (ret < 0) {
+      std::cerr << "Cannot find stream info: " << av_error_string(ret)
+                << std::endl;
+      if (is_udp_stream_) {
+        std::cerr << "Network stream may not be transmitting or connection failed" << std::endl;
+      }
+      return false;
+    }
+  }
+
+  video_stream_index_ = -1;
+  for (unsigned int i = 0; i < format_context_->nb_streams; i++) {
+    if (format_context_->streams[i]->codecpar->codec_type ==
+        AVMEDIA_TYPE_VIDEO) {
+      video_stream_index_ = i;
+      break;
+    }
+  }
+
+  if (video_stream_index_ == -1) {
+    std::cerr << "Cannot find video stream" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool VideoCapturer::open_camera_input() {
+  // Parse resolution
+  int width = 640, height = 480; // Default values
+  sscanf(resolution_.c_str(), "%dx%d", &width, &height);
+  std::cout << "Resolution: " << width << "x" << height << std::endl;
+  if (width < height) {
+    std::swap(width, height);
+    resolution_ = std::to_string(width) + "x" + std::to_string(height);
+  }
+  std::cout << "Using video input format: " << video_format_ << std::endl;
+
+  v4l2_source_.reset();
+  if (format_context_) {
+    avformat_close_input(&format_context_);
+    format_context_ = nullptr;
+  }
+
+  // 优先使用原生 V4L2 mmap 采集，帧数据零拷贝进入解码队列；
+  // 设备或格式不支持时回退到 libavdevice
+  auto source = std::make_unique<V4L2Source>(debug_enabled_);
+  if (source->open(device_, width, height, framerate_, video_format_)) {
+    v4l2_source_ = std::move(source);
+    video_stream_index_ = 0;
+    return true;
+  }
+  std::cout << "Native V4L2 capture unavailable, falling back to libavdevice"
+            << std::endl;
+
+  AVInputFormat *input_format = av_find_input_format("v4l2");
+  if (!input_format) {
+    std::cerr << "Cannot find V4L2 input input_format" << std::endl;
+    return false;
+  }
+
+  AVDictionary *options = nullptr;
+  av_dict_set(&options, "video_size", resolution_.c_str(), 0);
+  av_dict_set(&options, "framerate", std::to_string(framerate_).c_str(), 0);
+  av_dict_set(&options, "input_format", video_format_.c_str(),
+              0); // 使用视频输入格式参数
+  // 移除 pixel_format 设置，让 ffmpeg 自动检测
+  // 尺寸和格式由参数指定，万一需要探测也只读最少的数据
+  av_dict_set(&options, "probesize", "32", 0);
+  av_dict_set(&options, "analyzeduration", "0", 0);
+  int ret = avformat_open_input(&format_context_, device_.c_str(),
+                                input_format, &options);
+  av_dict_free(&options);
+  if (ret < 0) {
+    std::cerr << "Cannot open video device: " << av_error_string(ret)
+              << std::endl;
+    return false;
+  }
+  if (!find_video_stream(false)) {
+    return false;
+  }
+  if (camera_parameters_known()) {
+    // v4l2 demuxer 打开时已按协商结果填好参数，跳过读帧探测
+    AVStream *stream = format_context_->streams[video_stream_index_];
+    if (stream->avg_frame_rate.num <= 0 || stream->avg_frame_rate.den <= 0) {
+      stream->avg_frame_rate = AVRational{framerate_, 1};
+    }
+    return true;
+  }
+  std::cout << "Camera parameters incomplete, probing stream" << std::endl;
+  return find_video_stream(true);
+}
+
+bool VideoCapturer::camera_parameters_known() const {
+  const AVCodecParameters *params =
+      format_context_->streams[video_stream_index_]->codecpar;
+  if (params->codec_id == AV_CODEC_ID_NONE || params->width <= 0 ||
+      params->height <= 0) {
+    return false;
+  }
+  // rawvideo 还需要知道像素格式才能解码
+  return params->codec_id != AV_CODEC_ID_RAWVIDEO ||
+         params->format != AV_PIX_FMT_NONE;
+}
+
+void VideoCapturer::set_intra_refresh(bool enabled, bool idr_on_join) {
+  intra_refresh_ = enabled;
+  idr_on_join_ = idr_on_join;
+  if (enabled) {
+    std::cout << "Video intra refresh enabled"
+              << (idr_on_join ? ", IDR on viewer join"
+                              : ", no IDR on viewer join") << std::endl;
+  }
+}
+
+void VideoCapturer::set_max_slice_size(int bytes) {
+  max_slice_size_ = std::max(0, bytes);
+  if (max_slice_size_ > 0) {
+    std::cout << "Video slices limited to " << max_slice_size_ << " bytes"
+              << std::endl;
+  }
+}
+
+void VideoCapturer::set_codec_threads(int decoder_threads, int encoder_threads,
+                                      bool frame_threads) {
+  decoder_threads_ = std::max(0, decoder_threads);
+  encoder_threads_ = std::max(0, encoder_threads);
+  frame_threads_ = frame_threads;
+}
+
+void VideoCapturer::set_idle_grace_period(int seconds) {
+  idle_grace_seconds_ = std::max(0, seconds);
+}
+
+void VideoCapturer::wait_while_idle(AVPacket *packet) {
+  bool camera_input = !is_udp_stream_;
+  int64_t idle_since_us = steady_now_us();
+  bool standby_logged = false;
+
+  while (idle_ && is_running_) {
+    if (!camera_input || input_powered_down_) {
+      std::unique_lock<std::mutex> lock(callback_mutex_);
+      callback_cv_.wait(lock, [this] { return !idle_ || !is_running_; });
+      continue;
+    }
+
+    if (steady_now_us() - idle_since_us >=
+        static_cast<int64_t>(idle_grace_seconds_) * 1000000) {
+      std::lock_guard<std::mutex> lock(config_mutex_);
+      power_down_input();
+      continue;
+    }
+    if (!standby_logged) {
+      std::cout << "Video idle: camera in warm standby for "
+                << idle_grace_seconds_ << "s" << std::endl;
+      standby_logged = true;
+    }
+
+    // 热备：取出并丢弃驱动中的帧，缓冲区不积压
+    int ret;
+    {
+      std::lock_guard<std::mutex> lock(config_mutex_);
+      ret = read_input_packet(packet);
+    }
+    if (ret >= 0) {
+      av_packet_unref(packet);
+    } else if (ret != AVERROR(EAGAIN)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  // 有观看者后重新开流，失败时每秒重试直到成功或停止
+  while (input_powered_down_ && is_running_) {
+    {
+      std::lock_guard<std::mutex> lock(config_mutex_);
+      if (power_up_input()) {
+        break;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+  }
+}
+
+void VideoCapturer::power_down_input() {
+  if (v4l2_source_) {
+    if (!v4l2_source_->stop_streaming()) {
+      // 无法停止采集时关闭设备，恢复时重新打开
+      v4l2_source_.reset();
+    }
+  } else if (format_context_) {
+    // libavdevice 无法单独停止采集，直接关闭设备
+    avformat_close_input(&format_context_);
+    format_context_ = nullptr;
+  }
+  input_powered_down_ = true;
+  std::cout << "Video idle: camera streaming stopped" << std::endl;
+}
+
+bool VideoCapturer::power_up_input() {
+  begin_startup_timing("resume");
+  bool ok = (v4l2_source_ && v4l2_source_->start_streaming()) ||
+            open_camera_input();
+  if (!ok) {
+    std::cerr << "Video idle: failed to restart camera streaming" << std::endl;
+    return false;
+  }
+  input_powered_down_ = false;
+  log_startup_phase(StartupPhase::DeviceOpen);
+  std::cout << "Video idle: camera streaming resumed" << std::endl;
+  return true;
+}
+
+void VideoCapturer::begin_startup_timing(const char *reason) {
+  startup_reason_ = reason;
+  startup_begin_us_ = steady_now_us();
+  startup_logged_phases_ = 0;
+}
+
+void VideoCapturer::log_startup_phase(StartupPhase phase) {
+  unsigned bit = 1u << static_cast<unsigned>(phase);
+  // 每个阶段只记录第一次，之后只有一次原子读
+  if ((startup_logged_phases_.load(std::memory_order_relaxed) & bit) ||
+      (startup_logged_phases_.fetch_or(bit) & bit)) {
+    return;
+  }
+  static const char *const kPhaseNames[] = {"device open", "first packet",
+                                            "first encoded frame"};
+  int64_t elapsed_us = steady_now_us() - startup_begin_us_;
+  std::cout << "Video startup (" << startup_reason_.load() << "): "
+            << kPhaseNames[static_cast<unsigned>(phase)] << " after "
+            << elapsed_us / 1000 << "." << (elapsed_us % 1000) / 100 << " ms"
+            << std::endl;
+}
+
+const AVCodecParameters *VideoCapturer::input_codec_parameters() const {
+  if (v4l2_source_) {
+    return v4l2_source_->codec_parameters();
+  }
+  return format_context_->streams[video_stream_index_]->codecpar;
+}
+
+AVRational VideoCapturer::input_frame_rate() const {
+  if (v4l2_source_) {
+    return v4l2_source_->frame_rate();
+  }
+  return format_context_->streams[video_stream_index_]->avg_frame_rate;
+}
+
+int VideoCapturer::read_input_packet(AVPacket *packet) {
+  if (v4l2_source_) {
+    // 带超时等待，stop() 时采集线程能及时退出
+    return v4l2_source_->read_packet(packet, 100);
+  }
+  return av_read_frame(format_context_, packet);
+}
+
+int64_t VideoCapturer::input_time_us(int64_t pts) const {
+  if (pts == AV_NOPTS_VALUE) {
+    return steady_now_us();
+  }
+  if (v4l2_source_) {
+    // V4L2Source 的 pts 已经是微秒
+    return pts;
+  }
+  return av_rescale_q(pts,
+                      format_context_->streams[video_stream_index_]->time_base,
+                      AVRational{1, 1000000});
+}
+
+void VideoCapturer::update_pacing() {
+  // 计算实际采集/编码 FPS，避免只使用 num 导致不准确
+  int encoder_out_fps = encode_fps_;
+  AVRational avg_rate = input_frame_rate();
+  int capture_in_fps = 0;
+  if (avg_rate.den != 0) {
+    capture_in_fps = avg_rate.num / avg_rate.den;
+  }
+
+  if (encoder_out_fps <= 0) {
+    encoder_out_fps = framerate_;
+  }
+  if (capture_in_fps <= 0) {
+    capture_in_fps = encoder_out_fps;
+  }
+
+  // 按时间戳计划保留帧，小数比例（如 30->20）也能得到准确且均匀的输出帧率
+  int pacing_fps = encoder_out_fps < capture_in_fps ? encoder_out_fps : 0;
+  pacing_fps_ = pacing_fps;
+  std::cout << "Capture FPS: " << capture_in_fps
+            << ", Encode FPS: " << encoder_out_fps << ", Frame Pacing: "
+            << (pacing_fps > 0 ? "by timestamp" : "off") << std::endl;
+}
+
+bool VideoCapturer::pace_frame(int64_t timestamp_us) {
+  int fps = pacing_fps_;
+  if (fps != frame_pacer_.target_fps()) {
+    frame_pacer_.set_target_fps(fps);
+  }
+  return frame_pacer_.should_keep(timestamp_us);
 }
 
 void VideoCapturer::set_video_codec(const std::string &codec) {
@@ -314,136 +586,276 @@ void VideoCapturer::set_video_codec(const std::string &codec) {
   std::cout << "Video codec set to: " << video_codec_ << std::endl;
 }
 
-void VideoCapturer::reconfigure(const std::string &resolution, int fps, int bitrate, const std::string &format) {
-  // 使用互斥锁保护reconfigure操作，避免竞态条件
-  std::lock_guard<std::mutex> lock(config_mutex_);
+void VideoCapturer::set_output_resolution(const std::string &resolution) {
+  output_resolution_ = resolution;
+  if (!output_resolution_.empty()) {
+    std::cout << "Video output resolution set to: " << output_resolution_
+              << std::endl;
+  }
+}
 
-  std::cout << "Reconfiguring video capturer..." << std::endl;
+void VideoCapturer::output_size(int &width, int &height) const {
+  // 未指定输出分辨率时按采集分辨率编码
+  const std::string &resolution =
+      output_resolution_.empty() ? resolution_ : output_resolution_;
+  sscanf(resolution.c_str(), "%dx%d", &width, &height);
+}
 
-  // 暂停采集
-  pause_capture();
+int VideoCapturer::choose_decode_lowres(const AVCodec *codec,
+                                        const AVCodecParameters *codec_params,
+                                        int out_width, int out_height) {
+  // 目前只对 MJPEG 启用：JPEG 可以在 DCT 域直接按 1/2、1/4、1/8 缩小，
+  // 省掉绝大部分 IDCT 运算，缩小后的帧再交给 sws_scale 做剩余缩放
+  if (codec_params->codec_id != AV_CODEC_ID_MJPEG || out_width <= 0 ||
+      out_height <= 0) {
+    return 0;
+  }
+  for (int lowres = std::min<int>(codec->max_lowres, 3); lowres > 0;
+       --lowres) {
+    // 取仍能覆盖编码器输出尺寸的最大缩小倍数，避免放大损失清晰度
+    int scaled_width = AV_CEIL_RSHIFT(codec_params->width, lowres);
+    int scaled_height = AV_CEIL_RSHIFT(codec_params->height, lowres);
+    if (scaled_width >= out_width && scaled_height >= out_height) {
+      return lowres;
+    }
+  }
+  return 0;
+}
 
-  // 清空队列
-  decode_queue_.clear();
-  encode_queue_.clear();
-  send_queue_.clear();
+bool VideoCapturer::open_decoder(int out_width, int out_height) {
+  const AVCodecParameters *codec_params = input_codec_parameters();
+  const AVCodec *codec = avcodec_find_decoder(codec_params->codec_id);
+  if (!codec) {
+    std::cerr << "Cannot find decoder" << std::endl;
+    return false;
+  }
 
-  // 关闭旧编码器
-  encoder_->close_encoder();
+  codec_context_ = avcodec_alloc_context3(codec);
+  avcodec_parameters_to_context(codec_context_, codec_params);
 
-  // 清理旧资源
-  if (sws_context_) {
-    sws_freeContext(sws_context_);
-    sws_context_ = nullptr;
+  codec_context_->lowres =
+      choose_decode_lowres(codec, codec_params, out_width, out_height);
+  if (codec_context_->lowres > 0) {
+    std::cout << "MJPEG reduced-resolution decode: " << codec_params->width
+              << "x" << codec_params->height << " -> 1/"
+              << (1 << codec_context_->lowres) << " scale for "
+              << out_width << "x" << out_height << " output" << std::endl;
   }
 
-  if (codec_context_) {
-    avcodec_free_context(&codec_context_);
-    codec_context_ = nullptr;
+  // 线程数需在 avcodec_open2 之前设置，打开后修改不生效
+  CodecThreading threading =
+      choose_decoder_threading(codec, codec_params->width,
+                               codec_params->height, decoder_threads_,
+                               frame_threads_);
+  apply_codec_threading(codec_context_, threading);
+  if (int delay = codec_threading_delay_frames(threading)) {
+    std::cout << "Decoder using " << threading.thread_count
+              << " frame threads (adds " << delay << " frames of latency)"
+              << std::endl;
   }
 
-  if (format_context_) {
-    avformat_close_input(&format_context_);
-    format_context_ = nullptr;
+  int ret = avcodec_open2(codec_context_, codec, nullptr);
+  if (ret < 0) {
+    std::cerr << "Cannot open codec: " << av_error_string(ret) << std::endl;
+    return false;
   }
+  return true;
+}
 
-  // 清空帧池
-  clear_frame_pool();
+void VideoCapturer::set_camera_passthrough(bool enabled) {
+  camera_passthrough_ = enabled;
+  if (enabled) {
+    std::cout << "Camera H.264 passthrough enabled" << std::endl;
+  }
+}
+
+void VideoCapturer::request_keyframe() {
+  std::lock_guard<std::mutex> lock(encoder_mutex_);
+  if (encoder_) {
+    encoder_->request_keyframe();
+  } else if (camera_passthrough_ && v4l2_source_) {
+    // 直通模式下由摄像头自身的编码器输出 IDR
+    v4l2_source_->request_keyframe();
+  }
+}
+
+bool VideoCapturer::can_force_keyframe() {
+  std::lock_guard<std::mutex> lock(encoder_mutex_);
+  if (encoder_) {
+    return true;
+  }
+  return camera_passthrough_ && v4l2_source_ &&
+         v4l2_source_->can_force_keyframe();
+}
+
+void VideoCapturer::reconfigure_passthrough(const std::string &resolution,
+                                            int fps, int bitrate) {
+  // 只改变码率时直接设置摄像头的码率控制项，不重新开流
+  if (resolution == resolution_ && fps == framerate_ && v4l2_source_ &&
+      !input_powered_down_) {
+    if (bitrate > 0 && !v4l2_source_->set_bitrate(bitrate)) {
+      std::cout << "Camera bitrate control unavailable, keeping camera default"
+                << std::endl;
+    }
+    std::cout << "Video capturer bitrate updated in place (passthrough)"
+              << std::endl;
+    return;
+  }
+
+  // 内部暂停不进入空闲模式
+  Capture::pause_capture();
+  send_queue_.clear();
+  begin_startup_timing("reconfigure");
 
-  // 更新参数
   resolution_ = resolution;
   framerate_ = fps;
-  video_format_ = format;
+  // pause_capture 不等待采集线程，缓存由采集线程自己清空
+  reset_parameter_sets_ = true;
 
-  // 重新打开输入设备
-  AVInputFormat *input_format = av_find_input_format("v4l2");
-  if (!input_format) {
-    std::cerr << "Cannot find V4L2 input format" << std::endl;
+  // 分辨率和帧率需要重新协商，码率直接交给摄像头
+  if (!open_camera_input()) {
+    return;
+  }
+  log_startup_phase(StartupPhase::DeviceOpen);
+  if (input_codec_parameters()->codec_id != AV_CODEC_ID_H264) {
+    std::cerr << "Camera does not output H.264 after reconfigure" << std::endl;
     return;
   }
+  if (bitrate > 0 && !(v4l2_source_ && v4l2_source_->set_bitrate(bitrate))) {
+    std::cout << "Camera bitrate control unavailable, keeping camera default"
+              << std::endl;
+  }
 
-  std::string device_path = device_;
+  resume_capture();
+  std::cout << "Video capturer reconfigured successfully (passthrough)"
+            << std::endl;
+}
 
-  // 解析分辨率
-  int width = 640, height = 480;
-  sscanf(resolution_.c_str(), "%dx%d", &width, &height);
-  if (width < height) {
-    resolution_ = std::to_string(height) + "x" + std::to_string(width);
+void VideoCapturer::reconfigure(const std::string &resolution, int fps, int bitrate, const std::string &format,
+                                int rotation, bool mirror) {
+  // 使用互斥锁保护reconfigure操作，避免竞态条件
+  std::lock_guard<std::mutex> lock(config_mutex_);
+
+  std::cout << "Reconfiguring video capturer..." << std::endl;
+
+  if (camera_passthrough_) {
+    // 直通模式只能切换分辨率/帧率/码率，输入格式固定为 H.264
+    reconfigure_passthrough(resolution, fps, bitrate);
+    return;
+  }
+  // 非法角度保持当前旋转，之后的各条路径都使用校验后的值
+  rotation = checked_rotation(rotation);
+
+  // 只改变码率/帧率时直接调整运行中的编码器，不暂停采集也不重新打开设备和解码器
+  const std::string current_output =
+      output_resolution_.empty() ? resolution_ : output_resolution_;
+  bool same_output = resolution == current_output && rotation == rotation_ &&
+                     mirror == mirror_;
+  if (same_output && format == video_format_ && !input_powered_down_) {
+    std::lock_guard<std::mutex> encoder_lock(encoder_mutex_);
+    if (encoder_->update_rate_control(fps, bitrate)) {
+      encode_fps_ = fps;
+      update_pacing();
+      std::cout << "Video capturer rate updated in place: " << fps << "fps, "
+                << bitrate << "bps" << std::endl;
+      return;
+    }
   }
 
-  AVDictionary *options = nullptr;
-  av_dict_set(&options, "video_size", resolution_.c_str(), 0);
-  av_dict_set(&options, "framerate", std::to_string(framerate_).c_str(), 0);
-  av_dict_set(&options, "input_format", video_format_.c_str(), 0);
+  // 输出尺寸不超过当前解码尺寸时，在运行中的链路旁边建好新的编码器和缩放器再切换，
+  // 摄像头和解码器保持不变；放大、改变输入格式或提高帧率时才完整重建。
+  // MJPEG 降分辨率解码时解码尺寸小于采集尺寸，超过解码尺寸需重新选择 lowres
+  int out_width = 0, out_height = 0;
+  if (sscanf(resolution.c_str(), "%dx%d", &out_width, &out_height) == 2 &&
+      out_width > 0 && out_height > 0 && codec_context_ &&
+      out_width <= codec_context_->width &&
+      out_height <= codec_context_->height && format == video_format_ &&
+      fps <= framerate_ && !input_powered_down_) {
+    if (rebuild_output_chain(out_width, out_height, fps, bitrate, rotation,
+                             mirror)) {
+      output_resolution_ = resolution;
+      encode_fps_ = fps;
+      update_pacing();
+      std::cout << "Video output switching to " << resolution
+                << " without restarting capture" << std::endl;
+      return;
+    }
+    std::cerr << "Cannot build new output chain, restarting pipeline"
+              << std::endl;
+  }
 
-  std::cout << "Using video input format: " << video_format_ << std::endl;
+  // 暂停采集（内部暂停不进入空闲模式）
+  Capture::pause_capture();
+  begin_startup_timing("reconfigure");
+  discard_pending_output();
 
-  int ret = avformat_open_input(&format_context_, device_path.c_str(),
-                                input_format, &options);
-  if (ret < 0) {
-    std::cerr << "Cannot open video device: " << av_error_string(ret) << std::endl;
-    return;
+  // 清空队列
+  decode_queue_.clear();
+  encode_queue_.clear();
+  send_queue_.clear();
+
+  // 关闭旧编码器
+  encoder_->close_encoder();
+
+  // 清理旧资源
+  scaler_.reset();
+
+  if (codec_context_) {
+    avcodec_free_context(&codec_context_);
+    codec_context_ = nullptr;
   }
 
-  ret = avformat_find_stream_info(format_context_, nullptr);
-  if (ret < 0) {
-    std::cerr << "Cannot find stream info: " << av_error_string(ret) << std::endl;
-    return;
+  if (format_context_) {
+    avformat_close_input(&format_context_);
+    format_context_ = nullptr;
   }
 
-  video_stream_index_ = -1;
-  for (unsigned int i = 0; i < format_context_->nb_streams; i++) {
-    if (format_context_->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
-      video_stream_index_ = i;
-      break;
-    }
-  }
+  // 清空帧池
+  clear_frame_pool();
 
-  if (video_stream_index_ == -1) {
-    std::cerr << "Cannot find video stream" << std::endl;
-    return;
-  }
+  // 更新参数，摄像头直接按请求的分辨率采集
+  resolution_ = resolution;
+  output_resolution_.clear();
+  framerate_ = fps;
+  video_format_ = format;
+  set_rotation(rotation, mirror);
 
-  AVCodecParameters *codec_params = format_context_->streams[video_stream_index_]->codecpar;
-  const AVCodec *codec = avcodec_find_decoder(codec_params->codec_id);
-  if (!codec) {
-    std::cerr << "Cannot find decoder" << std::endl;
+  // 重新打开输入设备
+  if (!open_camera_input()) {
     return;
   }
+  log_startup_phase(StartupPhase::DeviceOpen);
 
-  codec_context_ = avcodec_alloc_context3(codec);
-  avcodec_parameters_to_context(codec_context_, codec_params);
+  int width = 640, height = 480;
+  output_size(width, height);
 
-  ret = avcodec_open2(codec_context_, codec, nullptr);
-  if (ret < 0) {
-    std::cerr << "Cannot open codec: " << av_error_string(ret) << std::endl;
+  if (!open_decoder(width, height)) {
     return;
   }
-
-  codec_context_->thread_count = 2;
+  // 输入格式可能在帧内/帧间编码之间切换（如 mjpeg -> h264），采集已暂停
+  update_input_policy();
 
   // 使用新参数配置编码器
+  if (rotation_swaps_dimensions(rotation_)) {
+    std::swap(width, height);
+  }
+  encoder_->set_full_range(input_full_range());
   if (!encoder_->open_encoder(width, height, fps, bitrate)) {
     std::cerr << "Failed to reconfigure encoder" << std::endl;
     return;
   }
+  encode_fps_ = fps;
 
   AVCodecContext *encoder_context = encoder_->get_context();
   if (!encoder_context) {
     std::cerr << "Encoder context is null after reconfiguration" << std::endl;
     return;
   }
-  encoder_out_width_ = encoder_context->width;
-  encoder_out_height_ = encoder_context->height;
-  encoder_out_pix_fmt_ = encoder_context->pix_fmt;
+  update_output_geometry(*encoder_);
 
   // 重新创建 SwsContext
-  sws_context_ = sws_getContext(
-      codec_context_->width, codec_context_->height, codec_context_->pix_fmt,
-      encoder_out_width_, encoder_out_height_, encoder_out_pix_fmt_,
-      SWS_BILINEAR, nullptr, nullptr, nullptr);
-
-  if (!sws_context_) {
+  if (!create_scaler(codec_context_->width, codec_context_->height,
+                     codec_context_->pix_fmt)) {
     std::cerr << "Cannot recreate SwsContext after reconfigure" << std::endl;
     return;
   }
@@ -455,14 +867,16 @@ void VideoCapturer::reconfigure(const std::string &resolution, int fps, int bitr
 }
 
 void VideoCapturer::capture_loop() {
-  AVPacket *packet = av_packet_alloc();
+  AVPacketPtr packet = make_av_packet();
 
-  if (is_udp_stream_) {
-    // 网络流模式（UDP/RTSP/SDP）：直接转发H.264数据包到发送队列
+  if (is_udp_stream_ || camera_passthrough_) {
+    // 网络流模式（UDP/RTSP/SDP）和摄像头直通模式：直接转发H.264数据包到发送队列
     bool is_rtsp = (device_.substr(0, 7) == "rtsp://");
     bool is_sdp = (device_.find(".sdp") != std::string::npos);
 
-    if (is_rtsp) {
+    if (camera_passthrough_) {
+      std::cout << "Camera capture loop started in passthrough mode" << std::endl;
+    } else if (is_rtsp) {
       std::cout << "RTSP capture loop started in direct forwarding mode" << std::endl;
     } else if (is_sdp) {
       std::cout << "SDP file capture loop started in direct forwarding mode" << std::endl;
@@ -470,26 +884,26 @@ void VideoCapturer::capture_loop() {
       std::cout << "UDP capture loop started in direct forwarding mode" << std::endl;
     }
 
-    // 等待 track_callbacks_ 被设置 (多peer支持)
-    {
-      std::unique_lock<std::mutex> lock(callback_mutex_);
-      callback_cv_.wait(lock, [this] { return !track_callbacks_.empty() || !is_running_; });
-    }
+    // 等待第一个观看者 (多peer支持)，期间摄像头按空闲模式处理
+    wait_while_idle(packet.get());
 
     if (!is_running_) {
-      av_packet_free(&packet);
       return;
     }
 
     while (is_running_) {
       // 检查是否暂停
       if (is_paused_) {
+        if (idle_) {
+          wait_while_idle(packet.get());
+          continue;
+        }
         std::unique_lock<std::mutex> lock(callback_mutex_);
         callback_cv_.wait(lock, [this] { return !is_paused_ || !is_running_; });
         continue;
       }
 
-      int ret = av_read_frame(format_context_, packet);
+      int ret = read_input_packet(packet.get());
       if (ret < 0) {
         if (ret != AVERROR(EAGAIN)) {
           std::this_thread::sleep_for(std::chrono::milliseconds(10));
@@ -497,80 +911,65 @@ void VideoCapturer::capture_loop() {
         continue;
       }
 
-      if (packet->stream_index == video_stream_index_) {
-        // 直接将H.264数据包放入发送队列
-        AVPacket *clone_packet = av_packet_alloc();
-        av_packet_ref(clone_packet, packet);
-
-        if (!send_queue_.try_push(clone_packet)) {
-          if (debug_enabled_) {
-            std::cout << "UDP stream: Send queue full, dropping packet" << std::endl;
-            std::cout << "Send queue Len: " << send_queue_.size()
-                      << ", Capacity: " << send_queue_.capacity() << std::endl;
-          }
-          av_packet_free(&clone_packet);
-          send_queue_.clear();
+      if (packet->stream_index != video_stream_index_) {
+        av_packet_unref(packet.get());
+        continue;
+      }
+      // 转发模式下输入包即编码帧
+      log_startup_phase(StartupPhase::FirstPacket);
+      log_startup_phase(StartupPhase::FirstEncodedFrame);
+
+      // 很多摄像头只在开流时输出一次 SPS/PPS，新 peer 需要在 IDR 前补上
+      if (video_codec_ == "h264") {
+        if (reset_parameter_sets_.exchange(false)) {
+          parameter_sets_.clear();
         }
+        parameter_sets_.process(packet.get());
       }
 
-      av_packet_unref(packet);
+      // 直接将H.264数据包移入发送队列，队列满时丢弃到下一个关键帧；
+      // 直通模式下同时请求摄像头输出 IDR
+      push_gop_aware(send_queue_, {std::move(packet), steady_now_us()},
+                     send_wait_keyframe_, camera_passthrough_);
+      wake_stage(PipelineStage::Send);
+      packet = make_av_packet();
     }
   } else {
     // 普通摄像头模式：需要解码和编码
     std::cout << "Camera capture loop started" << std::endl;
 
-    // 计算实际采集/编码 FPS，避免只使用 num 导致不准确
-    int encoder_out_fps = 0;
-    if (encoder_->get_context()->framerate.den != 0) {
-      encoder_out_fps = encoder_->get_context()->framerate.num /
-                        encoder_->get_context()->framerate.den;
-    }
-    AVRational avg_rate =
-        format_context_->streams[video_stream_index_]->avg_frame_rate;
-    int capture_in_fps = 0;
-    if (avg_rate.den != 0) {
-      capture_in_fps = avg_rate.num / avg_rate.den;
-    }
-
-    if (encoder_out_fps <= 0) {
-      encoder_out_fps = framerate_;
-    }
-    if (capture_in_fps <= 0) {
-      capture_in_fps = encoder_out_fps;
-    }
-
-    int frame_drop_factor = 1; // 默认值，可以根据需要调整
-    if (encoder_out_fps < capture_in_fps) {
-      frame_drop_factor =
-          std::max(1, static_cast<int>(std::round(static_cast<double>(capture_in_fps) /
-                                                  static_cast<double>(encoder_out_fps))));
-    }
-    int frame_counter = 0;
-    std::cout << "Capture FPS: " << capture_in_fps
-              << ", Encode FPS: " << encoder_out_fps
-              << ", Frame Drop Factor: " << frame_drop_factor << std::endl;
-
-    // 等待 track_callbacks_ 被设置 (多peer支持)
     {
-      std::unique_lock<std::mutex> lock(callback_mutex_);
-      callback_cv_.wait(lock, [this] { return !track_callbacks_.empty() || !is_running_; });
+      std::lock_guard<std::mutex> lock(config_mutex_);
+      update_pacing();
     }
 
+    // 等待第一个观看者 (多peer支持)，期间摄像头按空闲模式处理
+    wait_while_idle(packet.get());
+
     if (!is_running_) {
-      av_packet_free(&packet);
       return;
     }
 
     while (is_running_) {
       // 检查是否暂停
       if (is_paused_) {
-        // 等待 track_callback_ 被设置或恢复采集
-        std::unique_lock<std::mutex> lock(callback_mutex_);
-        callback_cv_.wait(lock, [this] { return !is_paused_ || !is_running_; });
+        if (idle_) {
+          wait_while_idle(packet.get());
+        } else {
+          // reconfigure 期间等待恢复采集
+          std::unique_lock<std::mutex> lock(callback_mutex_);
+          callback_cv_.wait(lock,
+                            [this] { return !is_paused_ || !is_running_; });
+        }
+        // reconfigure 会暂停采集，恢复后帧率可能已经改变
+        {
+          std::lock_guard<std::mutex> lock(config_mutex_);
+          update_pacing();
+        }
         continue;
       }
 
-      int ret = av_read_frame(format_context_, packet);
+      int ret = read_input_packet(packet.get());
       if (ret < 0) {
         if (ret != AVERROR(EAGAIN)) {
           std::this_thread::sleep_for(std::chrono::milliseconds(10));
@@ -578,278 +977,694 @@ void VideoCapturer::capture_loop() {
         continue;
       }
 
-      if (packet->stream_index == video_stream_index_) {
-        // 帧率控制逻辑：根据frame_drop_factor决定是否丢弃帧
-        frame_counter++;
-        if (frame_drop_factor > 1 && (frame_counter % frame_drop_factor) != 1) {
-          // 跳过这一帧（不进行解码）
-          av_packet_unref(packet);
-          continue;
-        }
+      if (packet->stream_index != video_stream_index_) {
+        av_packet_unref(packet.get());
+        continue;
+      }
+      log_startup_phase(StartupPhase::FirstPacket);
 
-        // 将数据包放入解码队列
-        AVPacket *clone_packet = av_packet_alloc();
-        av_packet_ref(clone_packet, packet);
-
-        // 使用非阻塞方式推入队列
-        if (!decode_queue_.try_push(clone_packet)) {
-          if (debug_enabled_) {
-            std::cout << "Video Decode queue full, dropping packet" << std::endl;
-            std::cout << "Video Decode queue Len: " << decode_queue_.size()
-                      << ", Capacity: " << decode_queue_.capacity()
-                      << std::endl;
-          }
-          av_packet_free(&clone_packet);
-          decode_queue_.clear();
-          encode_queue_.clear();
-          send_queue_.clear();
-        }
+      // 按时间戳降帧：帧内编码的包直接跳过，不进行解码
+      if (input_intra_only_ && !pace_frame(input_time_us(packet->pts))) {
+        av_packet_unref(packet.get());
+        continue;
       }
 
-      av_packet_unref(packet);
+      TimedPacket item{std::move(packet), steady_now_us()};
+      if (!input_intra_only_) {
+        push_gop_aware(decode_queue_, std::move(item), decode_wait_keyframe_,
+                       false);
+      } else if (!decode_queue_.try_push(std::move(item)) && debug_enabled_) {
+        // 将数据包的所有权移入解码队列，积压时由 Mailbox 策略只保留最新的帧
+        std::cout << "Video Decode queue full, dropping packet" << std::endl;
+        std::cout << "Video Decode queue Len: " << decode_queue_.size()
+                  << ", Capacity: " << decode_queue_.capacity()
+                  << std::endl;
+      }
+      wake_stage(PipelineStage::Decode);
+      packet = make_av_packet();
     }
   }
 
-  av_packet_free(&packet);
   std::cout << "Video capture stopped" << std::endl;
 }
 
-void VideoCapturer::decode_loop() {
-  AVFrame *frame = av_frame_alloc();
+bool VideoCapturer::decode_step() {
+  TimedPacket input;
+  for (size_t n = 0; n < kStageBatchSize && is_running_; ++n) {
+    if (!decode_queue_.try_pop(input)) {
+      return false;
+    }
+    decode_packet(std::move(input));
+  }
+  return is_running_ && !decode_queue_.empty();
+}
 
-  while (is_running_) {
-    AVPacket *packet = nullptr;
+void VideoCapturer::decode_packet(TimedPacket input) {
+  AVFrame *frame = decoded_frame_.get();
 
-    decode_queue_.wait_pop(packet);
+  // 超过解码阶段预算：帧内编码的包直接丢弃；帧间编码的包仍需解码以维持参考帧，
+  // 但跳过缩放和编码
+  bool stale = is_stale(PipelineStage::Decode, input.capture_us);
+  if (stale && input_intra_only_) {
+    return;
+  }
 
-    // nullptr 作为结束标记，方便线程在 stop() 时优雅退出
-    if (!packet) {
-      if (!is_running_) {
-        break;
-      }
-      continue;
+  int ret = avcodec_send_packet(codec_context_, input.packet.get());
+  if (ret < 0) {
+    if (debug_enabled_) {
+      std::cerr << "avcodec_send_packet failed: " << av_error_string(ret)
+                << std::endl;
     }
+    return;
+  }
 
-    int ret = avcodec_send_packet(codec_context_, packet);
-    if (ret < 0) {
+  while (ret >= 0) {
+    ret = avcodec_receive_frame(codec_context_, frame);
+    if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+      break;
+    } else if (ret < 0) {
       if (debug_enabled_) {
-        std::cerr << "avcodec_send_packet failed: " << av_error_string(ret)
+        std::cerr << "avcodec_receive_frame failed: " << av_error_string(ret)
                   << std::endl;
       }
-      av_packet_free(&packet);
+      break;
+    }
+
+    if (stale) {
       continue;
     }
 
-    while (ret >= 0) {
-      ret = avcodec_receive_frame(codec_context_, frame);
-      if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-        break;
-      } else if (ret < 0) {
-        if (debug_enabled_) {
-          std::cerr << "avcodec_receive_frame failed: " << av_error_string(ret)
-                    << std::endl;
-        }
-        break;
-      }
+    // 帧间编码的包都需要解码以维持参考帧，在解码后按时间戳降帧
+    if (!input_intra_only_ &&
+        !pace_frame(input_time_us(frame->best_effort_timestamp))) {
+      continue;
+    }
 
-      // 保存前几帧用于调试
-      if (debug_enabled_) {
-        static int saved_count = 0;
-        if (saved_count < 5) {
-          std::stringstream filename;
-          filename << "captured_frame_" << saved_count << "_" << frame->width
-                   << "x" << frame->height << ".ppm";
-          DebugUtils::save_frame_to_ppm(frame, filename.str());
-
-          std::stringstream yuv_filename;
-          yuv_filename << "captured_frame_" << saved_count << ".yuv";
-          DebugUtils::save_frame_to_yuv(frame, yuv_filename.str());
-
-          saved_count++;
-        }
-      }
+    // 保存前几帧用于调试
+    if (debug_enabled_) {
+      static int saved_count = 0;
+      if (saved_count < 5) {
+        std::stringstream filename;
+        filename << "captured_frame_" << saved_count << "_" << frame->width
+                 << "x" << frame->height << ".ppm";
+        DebugUtils::save_frame_to_ppm(frame, filename.str());
 
-      // 根据实际帧尺寸/像素格式检测是否需要重新创建 sws_context_
-      if (!sws_context_ || frame->width != codec_context_->width ||
-          frame->height != codec_context_->height ||
-          frame->format != codec_context_->pix_fmt) {
-        if (sws_context_) {
-          sws_freeContext(sws_context_);
-        }
-        sws_context_ = sws_getContext(
-            frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
-            encoder_out_width_, encoder_out_height_, encoder_out_pix_fmt_,
-            SWS_BILINEAR, nullptr, nullptr, nullptr);
-        if (!sws_context_) {
-          std::cerr << "Cannot recreate SwsContext for frame " << frame->width
-                    << "x" << frame->height << std::endl;
-          continue;
-        }
-      }
+        std::stringstream yuv_filename;
+        yuv_filename << "captured_frame_" << saved_count << ".yuv";
+        DebugUtils::save_frame_to_yuv(frame, yuv_filename.str());
 
-      // Convert frame format and put in encode queue using frame pool
-      AVFrame *scaled_frame = acquire_scaled_frame();
-      if (!scaled_frame) {
-        // 如果无法从池中获取，直接跳过本帧，避免崩溃
-        if (debug_enabled_) {
-          std::cerr << "Failed to acquire scaled frame from pool, dropping frame"
-                    << std::endl;
-        }
-        continue;
+        saved_count++;
       }
+    }
 
-      sws_scale(sws_context_, frame->data, frame->linesize, 0, frame->height,
-                scaled_frame->data, scaled_frame->linesize);
+    // 新的输出链路已建好时在帧边界切换
+    if (output_switch_pending_) {
+      switch_scale_output();
+    }
 
-      scaled_frame->pts = frame->pts;
+    AVFramePtr scaled_frame = scale_frame(frame);
+    if (!scaled_frame) {
+      continue;
+    }
 
-      // encode_queue_.wait_push(scaled_frame);
-      // 使用非阻塞方式推入队列
-      if (!encode_queue_.try_push(scaled_frame)) {
-        if (debug_enabled_) {
-          std::cout << "Video Encode queue full, dropping audio frame"
-                    << std::endl;
-          std::cout << "Video Encode queue Len: " << encode_queue_.size()
-                    << ", Capacity: " << encode_queue_.capacity()
-                    << std::endl;
-        }
-        release_scaled_frame(scaled_frame);
-        encode_queue_.clear();
-        send_queue_.clear();
-      }
+    if (fused_pipeline_) {
+      // 直接在本任务内编码，省去一次队列交接和任务调度
+      encode_and_queue(
+          {std::move(scaled_frame), input.capture_us, output_generation_});
+      continue;
+    }
+
+    // 使用非阻塞方式推入队列，积压时由 Mailbox 策略只保留最新的帧
+    if (!encode_queue_.try_push({std::move(scaled_frame), input.capture_us,
+                                 output_generation_}) &&
+        debug_enabled_) {
+      std::cout << "Video Encode queue full, dropping frame" << std::endl;
+      std::cout << "Video Encode queue Len: " << encode_queue_.size()
+                << ", Capacity: " << encode_queue_.capacity() << std::endl;
     }
+    wake_stage(PipelineStage::Encode);
+  }
+}
+
+bool VideoCapturer::encode_step() {
+  TimedFrame input;
+  for (size_t n = 0; n < kStageBatchSize && is_running_; ++n) {
+    if (!encode_queue_.try_pop(input)) {
+      return false;
+    }
+    encode_and_queue(std::move(input));
+  }
+  return is_running_ && !encode_queue_.empty();
+}
 
-    av_packet_free(&packet);
+void VideoCapturer::update_input_policy() {
+  // 摄像头直接输出 H.264 等帧间编码格式时，解码队列不能随意丢包，
+  // 改为由采集线程丢弃到下一个关键帧；解码前的降帧也只对帧内编码有效
+  const AVCodecDescriptor *descriptor =
+      avcodec_descriptor_get(input_codec_parameters()->codec_id);
+  input_intra_only_ =
+      descriptor && (descriptor->props & AV_CODEC_PROP_INTRA_ONLY);
+  if (input_intra_only_) {
+    decode_queue_.set_overflow_policy(OverflowPolicy::Mailbox,
+                                      kVideoMailboxDepth);
+  } else {
+    decode_queue_.set_overflow_policy(OverflowPolicy::Reject);
   }
+}
 
-  av_frame_free(&frame);
-  std::cout << "Video Decode thread exiting" << std::endl;
+bool VideoCapturer::input_full_range() const {
+  // JPEG 规定使用全范围 YUV，MJPEG 摄像头解码结果为 yuvj4xxp
+  const AVCodecParameters *codec_params = input_codec_parameters();
+  return codec_params->codec_id == AV_CODEC_ID_MJPEG ||
+         codec_params->color_range == AVCOL_RANGE_JPEG;
 }
 
-void VideoCapturer::encode_loop() {
-  AVPacket *packet = av_packet_alloc();
+bool VideoCapturer::create_scaler(int width, int height,
+                                  AVPixelFormat format) {
+  // 编码器 VUI 标记为 full range 时，输出保持全范围而不压缩到 16-235
+  bool ok = scaler_.init(width, height, format, scale_out_width_,
+                         scale_out_height_, encoder_out_pix_fmt_,
+                         scale_threads_, encode_full_range_);
+  scale_slices_ = static_cast<int>(scaler_.slice_count());
+  return ok;
+}
 
-  while (is_running_) {
-    AVFrame *frame = nullptr;
+void VideoCapturer::set_scale_threads(int threads) {
+  scale_threads_ = std::max(0, threads);
+}
 
-    encode_queue_.wait_pop(frame);
+void VideoCapturer::log_queue_stats(const std::string &label) {
+  Capture::log_queue_stats(label);
+  uint64_t count = scale_count_.exchange(0);
+  uint64_t total_us = scale_total_us_.exchange(0);
+  uint64_t max_us = scale_max_us_.exchange(0);
+  std::cout << "[" << label << "] scale: frames=" << count << ", avg_us="
+            << (count > 0 ? total_us / count : 0) << ", max_us=" << max_us
+            << ", slices=" << scale_slices_.load() << std::endl;
+
+  uint64_t frames = encode_count_.exchange(0);
+  uint64_t encode_us = encode_total_us_.exchange(0);
+  uint64_t bytes = encode_bytes_.exchange(0);
+  std::cout << "[" << label << "] encode: codec=" << video_codec_
+            << ", frames=" << frames << ", avg_us="
+            << (frames > 0 ? encode_us / frames : 0) << ", bytes=" << bytes
+            << ", kbps=" << bytes * 8 / 1000 / queue_stats_interval_
+            << std::endl;
+}
 
-    // nullptr 作为结束标记
-    if (!frame) {
-      if (!is_running_) {
-        break;
-      }
-      continue;
+void VideoCapturer::record_scale_time(int64_t elapsed_us) {
+  scale_count_.fetch_add(1, std::memory_order_relaxed);
+  scale_total_us_.fetch_add(elapsed_us, std::memory_order_relaxed);
+  uint64_t max_us = scale_max_us_.load(std::memory_order_relaxed);
+  while (static_cast<uint64_t>(elapsed_us) > max_us &&
+         !scale_max_us_.compare_exchange_weak(max_us, elapsed_us)) {
+  }
+}
+
+int VideoCapturer::checked_rotation(int rotation) const {
+  if (rotation != 0 && rotation != 90 && rotation != 180 && rotation != 270) {
+    std::cerr << "Unsupported rotation " << rotation << ", keeping "
+              << rotation_ << std::endl;
+    return rotation_;
+  }
+  return rotation;
+}
+
+void VideoCapturer::set_rotation(int rotation, bool mirror) {
+  rotation = checked_rotation(rotation);
+  if (rotation != rotation_ || mirror != mirror_) {
+    std::cout << "Video rotation set to " << rotation << " degrees"
+              << (mirror ? ", mirrored" : "") << std::endl;
+  }
+  rotation_ = rotation;
+  mirror_ = mirror;
+}
+
+void VideoCapturer::update_output_geometry(const Encoder &encoder) {
+  AVCodecContext *encoder_context = encoder.get_context();
+  encode_full_range_ = encoder.full_range();
+  encoder_out_width_ = encoder_context->width;
+  encoder_out_height_ = encoder_context->height;
+  encoder_out_pix_fmt_ = encoder_context->pix_fmt;
+  // 缩放/转换输出旋转前的尺寸，旋转后才与编码器一致
+  if (rotation_swaps_dimensions(rotation_)) {
+    scale_out_width_ = encoder_out_height_;
+    scale_out_height_ = encoder_out_width_;
+  } else {
+    scale_out_width_ = encoder_out_width_;
+    scale_out_height_ = encoder_out_height_;
+  }
+  rotate_scratch_.reset();
+}
+
+std::unique_ptr<Encoder> VideoCapturer::make_encoder() const {
+  std::unique_ptr<Encoder> encoder =
+      create_video_encoder(video_codec_, debug_enabled_);
+  encoder->set_intra_refresh(intra_refresh_);
+  encoder->set_max_slice_size(max_slice_size_);
+  encoder->set_threading(encoder_threads_, frame_threads_);
+  return encoder;
+}
+
+bool VideoCapturer::rebuild_output_chain(int width, int height, int fps,
+                                         int bitrate, int rotation,
+                                         bool mirror) {
+  auto chain = std::make_unique<OutputChain>();
+  chain->encoder = make_encoder();
+  chain->rotation = rotation;
+  chain->mirror = mirror;
+  chain->requested_us = steady_now_us();
+
+  int encoder_width = width, encoder_height = height;
+  if (rotation_swaps_dimensions(rotation)) {
+    std::swap(encoder_width, encoder_height);
+  }
+  chain->encoder->set_full_range(input_full_range());
+  if (!chain->encoder->open_encoder(encoder_width, encoder_height, fps,
+                                    bitrate)) {
+    return false;
+  }
+  // 缩放器按当前解码输出创建，实际帧尺寸不同时解码任务会重新创建
+  if (!chain->scaler.init(codec_context_->width, codec_context_->height,
+                          codec_context_->pix_fmt, width, height,
+                          chain->encoder->get_context()->pix_fmt,
+                          scale_threads_, chain->encoder->full_range())) {
+    return false;
+  }
+  chain->generation = ++output_chain_counter_;
+
+  std::unique_ptr<OutputChain> replaced;
+  {
+    std::lock_guard<std::mutex> lock(output_chain_mutex_);
+    // 尚未切换的上一次重建直接作废
+    replaced = std::move(pending_output_);
+    pending_output_ = std::move(chain);
+    output_switch_pending_ = true;
+  }
+  release_output_chain(std::move(replaced));
+  return true;
+}
+
+void VideoCapturer::switch_scale_output() {
+  std::unique_ptr<OutputChain> chain;
+  {
+    std::lock_guard<std::mutex> lock(output_chain_mutex_);
+    chain = std::move(pending_output_);
+    output_switch_pending_ = false;
+  }
+  if (!chain) {
+    return;
+  }
+
+  // 交换后 chain 持有旧的缩放器，随编码器切换后一起释放
+  scaler_.swap(chain->scaler);
+  scale_slices_ = static_cast<int>(scaler_.slice_count());
+  {
+    std::lock_guard<std::mutex> lock(frame_pool_mutex_);
+    rotation_ = chain->rotation;
+    mirror_ = chain->mirror;
+    update_output_geometry(*chain->encoder);
+    scaled_frame_pool_.clear();
+  }
+  output_generation_ = chain->generation;
+
+  std::unique_ptr<OutputChain> replaced;
+  {
+    std::lock_guard<std::mutex> lock(output_chain_mutex_);
+    replaced = std::move(pending_encoder_);
+    pending_encoder_ = std::move(chain);
+  }
+  release_output_chain(std::move(replaced));
+}
+
+bool VideoCapturer::switch_encoder(uint32_t generation) {
+  std::unique_ptr<OutputChain> chain;
+  {
+    std::lock_guard<std::mutex> lock(output_chain_mutex_);
+    if (pending_encoder_ && pending_encoder_->generation == generation) {
+      chain = std::move(pending_encoder_);
     }
+  }
+  if (!chain) {
+    return false;
+  }
 
-    bool encoded = encoder_->encode_frame(frame, packet);
-    // 使用 frame pool 复用内存
-    release_scaled_frame(frame);
+  {
+    std::lock_guard<std::mutex> lock(encoder_mutex_);
+    encoder_.swap(chain->encoder);
+  }
+  encoder_generation_ = generation;
+  AVCodecContext *encoder_context = encoder_->get_context();
+  std::cout << "Video encoder switched to " << encoder_context->width << "x"
+            << encoder_context->height << " after "
+            << (steady_now_us() - chain->requested_us) / 1000
+            << " ms since reconfigure" << std::endl;
+  release_output_chain(std::move(chain));
+  return true;
+}
 
-    if (encoded) {
-      // Put packet in send queue
-      // Clone packet for sending thread
-      AVPacket *clone_packet = av_packet_alloc();
-      av_packet_ref(clone_packet, packet);
-        send_queue_.wait_push(clone_packet);
+void VideoCapturer::discard_pending_output() {
+  std::unique_ptr<OutputChain> output, encoder;
+  {
+    std::lock_guard<std::mutex> lock(output_chain_mutex_);
+    output = std::move(pending_output_);
+    encoder = std::move(pending_encoder_);
+    output_switch_pending_ = false;
+  }
+  release_output_chain(std::move(output));
+  release_output_chain(std::move(encoder));
+  // 完整重建后解码和编码阶段从同一个版本开始
+  output_generation_ = encoder_generation_ = ++output_chain_counter_;
+}
 
-      av_packet_unref(packet);
+void VideoCapturer::release_output_chain(std::unique_ptr<OutputChain> chain) {
+  if (!chain) {
+    return;
+  }
+  // 关闭 libx264/libx265 需要等待其内部线程退出，放到线程池上，不阻塞当前阶段
+  std::shared_ptr<OutputChain> retired(std::move(chain));
+  Executor::shared().submit(TaskPriority::Normal,
+                            [retired]() mutable { retired.reset(); });
+}
+
+AVFrame *VideoCapturer::rotate_scratch_frame() {
+  if (!rotate_scratch_) {
+    rotate_scratch_ = make_av_frame();
+    if (!rotate_scratch_) {
+      return nullptr;
+    }
+    rotate_scratch_->format = encoder_out_pix_fmt_;
+    rotate_scratch_->width = scale_out_width_;
+    rotate_scratch_->height = scale_out_height_;
+    if (av_frame_get_buffer(rotate_scratch_.get(), 0) < 0) {
+      rotate_scratch_.reset();
+      return nullptr;
     }
   }
+  return rotate_scratch_.get();
+}
+
+bool VideoCapturer::convert_for_encoder(AVFrame *frame, AVFrame *target) {
+  // 同尺寸重排（如 YUYV422 -> YUV420P）和缩小一半走手写 SIMD 转换，
+  // 其余情况才使用通用的 sws_scale
+  // 这些摄像头格式均为有限范围，编码器标记 full range 时仍交给 sws_scale 转换
+  if (!encode_full_range_ && fast_convert_frame(frame, target)) {
+    return true;
+  }
 
-  av_packet_free(&packet);
-  std::cout << "Video Encode thread exiting" << std::endl;
+  // 根据实际帧尺寸/像素格式检测是否需要重新创建缩放上下文
+  if (!scaler_.matches(frame->width, frame->height,
+                       static_cast<AVPixelFormat>(frame->format)) &&
+      !create_scaler(frame->width, frame->height,
+                     static_cast<AVPixelFormat>(frame->format))) {
+    std::cerr << "Cannot recreate SwsContext for frame " << frame->width
+              << "x" << frame->height << std::endl;
+    return false;
+  }
+  // 按水平条带在线程池上并行缩放
+  scaler_.scale(frame, target);
+  return true;
 }
 
-void VideoCapturer::send_loop() {
-  while (is_running_) {
-    AVPacket *packet = nullptr;
+bool VideoCapturer::frame_matches_encoder(const AVFrame *frame) const {
+  if (frame->width != scale_out_width_ ||
+      frame->height != scale_out_height_) {
+    return false;
+  }
+  // yuvj420p 与 yuv420p 内存布局相同，只是取值范围不同
+  AVPixelFormat format = static_cast<AVPixelFormat>(frame->format);
+  bool full_range = format == AV_PIX_FMT_YUVJ420P ||
+                    frame->color_range == AVCOL_RANGE_JPEG;
+  if (format == AV_PIX_FMT_YUVJ420P) {
+    format = AV_PIX_FMT_YUV420P;
+  }
+  return format == encoder_out_pix_fmt_ &&
+         full_range == encode_full_range_;
+}
 
-    // Get packet from send queue
-    send_queue_.wait_pop(packet);
+AVFramePtr VideoCapturer::scale_frame(AVFrame *frame) {
+  bool transform = rotation_ != 0 || mirror_;
+  bool layout_matches = frame_matches_encoder(frame);
+  // 解码帧的尺寸和布局与编码器输入一致时直接引用解码器的缓冲区，
+  // 省去一次整帧拷贝和缩放
+  if (layout_matches && !transform) {
+    AVFramePtr ref = make_av_frame();
+    if (!ref || av_frame_ref(ref.get(), frame) < 0) {
+      return nullptr;
+    }
+    ref->format = encoder_out_pix_fmt_;
+    return ref;
+  }
 
-    // nullptr 作为结束标记
-    if (!packet) {
-      if (!is_running_) {
-        break;
-      }
-      continue;
+  // Convert frame format using frame pool
+  AVFramePtr scaled_frame = acquire_scaled_frame();
+  if (!scaled_frame) {
+    // 如果无法从池中获取，直接跳过本帧，避免崩溃
+    if (debug_enabled_) {
+      std::cerr << "Failed to acquire scaled frame from pool, dropping frame"
+                << std::endl;
     }
+    return nullptr;
+  }
 
-    if (!is_running_) {
-      av_packet_free(&packet);
-      break;
+  int64_t start_us = steady_now_us();
+  // 需要旋转时先转换到临时帧再旋转写入输出帧；布局已一致时旋转本身就是唯一的一次拷贝
+  const AVFrame *converted = frame;
+  if (!layout_matches) {
+    AVFrame *target = transform ? rotate_scratch_frame() : scaled_frame.get();
+    if (!target || !convert_for_encoder(frame, target)) {
+      release_scaled_frame(std::move(scaled_frame));
+      return nullptr;
     }
+    converted = target;
+  }
+  if (transform &&
+      !rotate_frame(converted, scaled_frame.get(), rotation_, mirror_)) {
+    std::cerr << "Cannot rotate frame by " << rotation_ << " degrees"
+              << std::endl;
+    release_scaled_frame(std::move(scaled_frame));
+    return nullptr;
+  }
+  int64_t elapsed_us = steady_now_us() - start_us;
+  record_scale_time(elapsed_us);
+  if (debug_enabled_) {
+    std::cout << "Video scale " << frame->width << "x" << frame->height
+              << " -> " << encoder_out_width_ << "x" << encoder_out_height_
+              << " took " << elapsed_us << " us" << std::endl;
+  }
 
-    // Send data to all registered callbacks (multiple peer support)
-    auto data = reinterpret_cast<const std::byte *>(packet->data);
-    size_t data_size = packet->size;
+  scaled_frame->pts = frame->pts;
+  return scaled_frame;
+}
+
+void VideoCapturer::encode_and_queue(TimedFrame input) {
+  AVPacketPtr &packet = encode_packet_;
+
+  // 原始帧之间没有依赖，超过编码阶段预算的帧直接放回帧池
+  if (is_stale(PipelineStage::Encode, input.capture_us)) {
+    release_scaled_frame(std::move(input.frame));
+    return;
+  }
+
+  // 第一帧新链路的帧到达时切换编码器；切换前旧尺寸的帧仍由旧编码器编码，
+  // 比当前编码器更旧的帧直接丢弃
+  if (input.generation != encoder_generation_ &&
+      !switch_encoder(input.generation)) {
+    release_scaled_frame(std::move(input.frame));
+    return;
+  }
+
+  int64_t encode_start_us = steady_now_us();
+  bool encoded = encoder_->encode_frame(input.frame.get(), packet.get());
+  encode_count_.fetch_add(1, std::memory_order_relaxed);
+  encode_total_us_.fetch_add(steady_now_us() - encode_start_us,
+                             std::memory_order_relaxed);
+  if (encoded) {
+    encode_bytes_.fetch_add(packet->size, std::memory_order_relaxed);
+  }
+  // 使用 frame pool 复用内存
+  release_scaled_frame(std::move(input.frame));
+
+  if (encoded) {
+    log_startup_phase(StartupPhase::FirstEncodedFrame);
+    // 将编码后的包移交给发送任务；发送队列满时丢弃到下一个关键帧并立即请求 IDR，
+    // 拥塞恢复只需一帧时间而不必等待整个 GOP
+    push_gop_aware(send_queue_, {std::move(packet), input.capture_us},
+                   send_wait_keyframe_, true);
+    wake_stage(PipelineStage::Send);
+    packet = make_av_packet();
+  }
+}
+
+bool VideoCapturer::send_step() {
+  // 一次取出队列中所有已就绪的包（如被拆分成多个包的 IDR 帧），
+  // 整批只加一次 callbacks 锁
+  constexpr size_t kSendBatchSize = 64;
+  std::vector<TimedPacket> &packets = send_batch_;
+  bool &dropping_until_keyframe = send_dropping_until_keyframe_;
+
+  packets.clear();
+  if (!is_running_ || send_queue_.try_pop_bulk(packets, kSendBatchSize) == 0) {
+    return false;
+  }
+
+  // 已编码的包之间存在依赖：某个包超过发送阶段预算被丢弃后，
+  // 其后的包一直丢弃到下一个关键帧，并立即请求 IDR
+  auto stale_end = std::remove_if(
+      packets.begin(), packets.end(), [&](const TimedPacket &item) {
+        bool is_keyframe = item.packet->flags & AV_PKT_FLAG_KEY;
+        if (dropping_until_keyframe && !is_keyframe) {
+          return true;
+        }
+        if (is_stale(PipelineStage::Send, item.capture_us)) {
+          dropping_until_keyframe = true;
+          send_wait_keyframe_ = true;
+          request_keyframe();
+          return true;
+        }
+        dropping_until_keyframe = false;
+        return false;
+      });
+  packets.erase(stale_end, packets.end());
+  if (packets.empty()) {
+    return is_running_ && !send_queue_.empty();
+  }
 
+  {
     // 使用互斥锁保护callbacks map的访问
     std::lock_guard<std::mutex> lock(callbacks_mutex_);
 
-    for (const auto &pair : track_callbacks_) {
-      if (pair.second) {
-        pair.second(data, data_size);
+    // Send data to all registered callbacks (multiple peer support)
+    for (const auto &item : packets) {
+      const AVPacketPtr &packet = item.packet;
+      auto data = reinterpret_cast<const std::byte *>(packet->data);
+      size_t data_size = packet->size;
+      for (const auto &pair : track_callbacks_) {
+        if (pair.second) {
+          pair.second(data, data_size);
+        }
       }
     }
 
     if (debug_enabled_ && !track_callbacks_.empty()) {
-      std::cout << "Video sent: size=" << packet->size
+      std::cout << "Video sent: packets=" << packets.size()
                 << ", Callbacks: " << track_callbacks_.size() << std::endl;
     } else if (debug_enabled_) {
       std::cout << "Drop packet! No callback set." << std::endl;
     }
+  }
+
+  packets.clear();
+  return is_running_ && !send_queue_.empty();
+}
+
+bool VideoCapturer::push_gop_aware(SafeQueue<TimedPacket> &queue,
+                                   TimedPacket item,
+                                   std::atomic<bool> &waiting_for_keyframe,
+                                   bool request_idr) {
+  bool is_keyframe = item.packet->flags & AV_PKT_FLAG_KEY;
+  if (waiting_for_keyframe && !is_keyframe) {
+    // 参考帧已被丢弃，依赖它的帧发出去也无法正确解码
+    return false;
+  }
+
+  if (queue.try_push(std::move(item))) {
+    if (is_keyframe) {
+      waiting_for_keyframe = false;
+    }
+    return true;
+  }
+
+  // 队列已满：丢弃该包，并丢弃其后所有依赖帧直到下一个关键帧
+  bool already_waiting = waiting_for_keyframe.exchange(true);
+  if (request_idr && (!already_waiting || is_keyframe)) {
+    request_keyframe();
+  }
+  if (debug_enabled_ && !already_waiting) {
+    std::cout << "Video queue full (Len: " << queue.size()
+              << ", Capacity: " << queue.capacity()
+              << "), dropping until next keyframe" << std::endl;
+  }
+  return false;
+}
+
+void VideoCapturer::pause_capture() {
+  idle_ = true;
+  Capture::pause_capture();
+}
+
+void VideoCapturer::resume_capture() {
+  // 帧内刷新模式下已有观看者时，新观看者默认等待下一轮刷新，不打断其他观看者的码流
+  bool already_streaming = !idle_ && !is_paused_;
+  if (already_streaming && intra_refresh_ && !idr_on_join_) {
+    std::cout << "Viewer joined, waiting for next intra refresh cycle"
+              << std::endl;
+    return;
+  }
+
+  if (already_streaming) {
+    // 其他观看者正在观看，码流是连续的：只请求 IDR 让新观看者尽快开始解码，
+    // 不能丢弃到下一个关键帧，否则无法强制 IDR 时所有观看者都会卡住一个 GOP
+    request_keyframe();
+    return;
+  }
 
-    av_packet_free(&packet);
+  {
+    // 与 wait_while_idle 中的条件等待使用同一把锁，避免错过唤醒
+    std::lock_guard<std::mutex> lock(callback_mutex_);
+    idle_ = false;
   }
-  std::cout << "Video Send thread exiting" << std::endl;
+  // 暂停时清空了各队列，恢复后从关键帧重新开始发送；
+  // 无法强制关键帧时不等待，否则要停顿到上游自己的下一个 IDR
+  decode_wait_keyframe_ = true;
+  send_wait_keyframe_ = can_force_keyframe();
+  request_keyframe();
+  Capture::resume_capture();
 }
 
-AVFrame *VideoCapturer::acquire_scaled_frame() {
+AVFramePtr VideoCapturer::acquire_scaled_frame() {
   std::lock_guard<std::mutex> lock(frame_pool_mutex_);
-  AVFrame *frame = nullptr;
+  AVFramePtr frame;
   if (!scaled_frame_pool_.empty()) {
-    frame = scaled_frame_pool_.back();
+    frame = std::move(scaled_frame_pool_.back());
     scaled_frame_pool_.pop_back();
   } else {
-    frame = av_frame_alloc();
+    frame = make_av_frame();
     if (!frame) {
       return nullptr;
     }
     frame->format = encoder_out_pix_fmt_;
     frame->width = encoder_out_width_;
     frame->height = encoder_out_height_;
-    if (av_frame_get_buffer(frame, 0) < 0) {
-      av_frame_free(&frame);
+    // 标记为帧池分配的帧，引用解码器缓冲区的帧不回收到帧池
+    frame->opaque = &scaled_frame_pool_;
+    if (av_frame_get_buffer(frame.get(), 0) < 0) {
       return nullptr;
     }
   }
   // 确保数据可写
-  if (av_frame_make_writable(frame) < 0) {
+  if (av_frame_make_writable(frame.get()) < 0) {
     return nullptr;
   }
   return frame;
 }
 
-void VideoCapturer::release_scaled_frame(AVFrame *frame) {
-  if (!frame) {
+void VideoCapturer::release_scaled_frame(AVFramePtr frame) {
+  if (!frame || frame->opaque != &scaled_frame_pool_) {
+    // 直接引用解码器缓冲区的帧在这里释放，缓冲区归还给解码器
     return;
   }
   std::lock_guard<std::mutex> lock(frame_pool_mutex_);
-  // 简单限制池大小，避免无限增长
+  // 简单限制池大小，避免无限增长，超出时由句柄释放；输出尺寸切换前的帧不再回收
   constexpr size_t kMaxPoolSize = 32;
-  if (scaled_frame_pool_.size() < kMaxPoolSize) {
-    scaled_frame_pool_.push_back(frame);
-  } else {
-    av_frame_free(&frame);
+  if (scaled_frame_pool_.size() < kMaxPoolSize &&
+      frame->width == encoder_out_width_ &&
+      frame->height == encoder_out_height_) {
+    scaled_frame_pool_.push_back(std::move(frame));
   }
 }
 
 void VideoCapturer::clear_frame_pool() {
   std::lock_guard<std::mutex> lock(frame_pool_mutex_);
-  for (auto *frame : scaled_frame_pool_) {
-    av_frame_free(&frame);
-  }
   scaled_frame_pool_.clear();
 }
\ No newline at end of file
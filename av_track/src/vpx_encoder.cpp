@@ -0,0 +1,142 @@
+#include "vpx_encoder.h"
+#include "codec_threads.h"
+#include "encoder.h"
+#include <iostream>
+
+extern "C" {
+#include <libavutil/avutil.h>
+#include <libavutil/opt.h>
+}
+
+extern std::string av_error_string(int errnum);
+
+VpxEncoder::VpxEncoder(Codec codec, bool debug_enabled)
+    : codec_type_(codec), debug_enabled_(debug_enabled),
+      encoder_context_(nullptr), codec_(nullptr) {}
+
+VpxEncoder::~VpxEncoder() { close_encoder(); }
+
+bool VpxEncoder::open_encoder(int width, int height, int fps, int64_t bit_rate) {
+  codec_ = avcodec_find_encoder_by_name(codec_type_ == Codec::VP9 ? "libvpx-vp9"
+                                                                  : "libvpx");
+  if (!codec_) {
+    std::cerr << "Cannot find " << name() << " encoder (libvpx)" << std::endl;
+    return false;
+  }
+
+  encoder_context_ = avcodec_alloc_context3(codec_);
+  open_fps_ = fps;
+  open_bit_rate_ = bit_rate;
+
+  // ==================== 基础视频参数配置 ====================
+  encoder_context_->width = width;
+  encoder_context_->height = height;
+  encoder_context_->time_base = {1, fps};
+  encoder_context_->framerate = {fps, 1};
+  encoder_context_->max_b_frames = 0;
+  encoder_context_->pix_fmt = AV_PIX_FMT_YUV420P;
+
+  // VP8 码流不能标记全范围，由缩放器压缩到 16-235；VP9 在帧头中标记 color_range
+  if (codec_type_ == Codec::VP8) {
+    full_range_ = false;
+  }
+  encoder_context_->color_range =
+      full_range_ ? AVCOL_RANGE_JPEG : AVCOL_RANGE_MPEG;
+
+  // 码率控制：指定码率时使用 CBR（与 WebRTC 一致），否则按质量编码
+  if (bit_rate > 0) {
+    encoder_context_->bit_rate = bit_rate;
+    encoder_context_->rc_min_rate = bit_rate;
+    encoder_context_->rc_max_rate = bit_rate;
+    encoder_context_->rc_buffer_size = bit_rate;
+  } else {
+    // VP9 为恒定质量模式；VP8 没有纯质量模式，FFmpeg 使用默认码率上限的 CQ 模式
+    av_opt_set(encoder_context_->priv_data, "crf",
+               codec_type_ == Codec::VP9 ? "32" : "10", 0);
+  }
+
+  // 实时编码：不向前看，最快速度档
+  av_opt_set(encoder_context_->priv_data, "deadline", "realtime", 0);
+  av_opt_set(encoder_context_->priv_data, "cpu-used", "8", 0);
+  av_opt_set(encoder_context_->priv_data, "lag-in-frames", "0", 0);
+
+  if (intra_refresh_) {
+    // libvpx 封装没有周期性帧内刷新，改为每秒一个关键帧，新观看者最多等待 1 秒
+    encoder_context_->gop_size = fps;
+    std::cout << name() << " has no intra refresh, using " << fps
+              << "-frame keyframe interval" << std::endl;
+  }
+
+  CodecThreading threading = choose_encoder_threading(
+      width, height, requested_threads_, frame_threads_);
+  apply_codec_threading(encoder_context_, threading);
+  if (codec_type_ == Codec::VP9) {
+    // VP9 按 tile 列和行并行，不增加延迟
+    av_opt_set_int(encoder_context_->priv_data, "tile-columns",
+                   tile_columns_log2(width, threading.thread_count), 0);
+    av_opt_set_int(encoder_context_->priv_data, "row-mt", 1, 0);
+  }
+  std::cout << name() << " Encoder Using " << encoder_context_->thread_count
+            << " threads" << std::endl;
+
+  int ret = avcodec_open2(encoder_context_, codec_, nullptr);
+  if (ret < 0) {
+    std::cerr << "Cannot open " << name() << " encoder: "
+              << av_error_string(ret) << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void VpxEncoder::close_encoder() {
+  if (encoder_context_) {
+    avcodec_free_context(&encoder_context_);
+    encoder_context_ = nullptr;
+  }
+}
+
+bool VpxEncoder::encode_frame(AVFrame *frame, AVPacket *packet) {
+  // Ensure frame has timestamp
+  static int64_t pts = 0;
+  if (frame && frame->pts == AV_NOPTS_VALUE) {
+    frame->pts = pts++;
+  }
+
+  // libvpx 封装不支持运行中修改码率，在编码线程内以新码率重新打开；
+  // 失败时继续使用原编码器
+  int64_t bit_rate = 0;
+  if (take_rate_update(bit_rate) && !reopen_with_bit_rate(bit_rate)) {
+    std::cerr << "Cannot reopen " << name()
+              << " encoder with new bitrate, keeping previous settings"
+              << std::endl;
+  }
+
+  if (frame) {
+    // 帧来自复用的帧池，每次都显式设置帧类型；I 帧被强制编码为关键帧
+    frame->pict_type = keyframe_requested_.exchange(false) ? AV_PICTURE_TYPE_I
+                                                           : AV_PICTURE_TYPE_NONE;
+  }
+
+  int ret = avcodec_send_frame(encoder_context_, frame);
+  if (ret < 0) {
+    return false;
+  }
+
+  ret = avcodec_receive_packet(encoder_context_, packet);
+  if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+    return false;
+  } else if (ret < 0) {
+    std::cerr << "Error receiving packet from encoder: " << av_error_string(ret)
+              << std::endl;
+    return false;
+  }
+
+  if (debug_enabled_) {
+    std::cout << name() << " packet size: " << packet->size
+              << ", packet pts: " << packet->pts
+              << ", keyframe: " << (packet->flags & AV_PKT_FLAG_KEY)
+              << std::endl;
+  }
+
+  return true;
+}
@@ -0,0 +1,96 @@
+#include "vpx_packetizer.h"
+#include <algorithm>
+#include <utility>
+
+namespace {
+// VP8 描述符：X|R|N|S|R|PID(3)，扩展字节 I|L|T|K|RSV(4)
+constexpr uint8_t kVp8Extended = 0x80;
+constexpr uint8_t kVp8StartOfPartition = 0x10;
+constexpr uint8_t kVp8PictureIdPresent = 0x80;
+// VP9 描述符：I|P|L|F|B|E|V|Z
+constexpr uint8_t kVp9PictureIdPresent = 0x80;
+constexpr uint8_t kVp9InterPredicted = 0x40;
+constexpr uint8_t kVp9StartOfFrame = 0x08;
+constexpr uint8_t kVp9EndOfFrame = 0x04;
+// PictureID 使用 15 位格式（M=1）
+constexpr uint8_t kLongPictureId = 0x80;
+
+// 只解析未压缩帧头的前几位：frame_marker、profile、show_existing_frame、frame_type
+bool vp9_is_keyframe(const rtc::binary &data) {
+  if (data.empty()) {
+    return false;
+  }
+  uint8_t header = std::to_integer<uint8_t>(data[0]);
+  int bit = 7;
+  auto read_bit = [&]() { return (header >> bit--) & 1; };
+  if (read_bit() != 1 || read_bit() != 0) {
+    return false; // frame_marker 必须为 2
+  }
+  int profile = read_bit();
+  profile |= read_bit() << 1;
+  if (profile == 3) {
+    read_bit(); // reserved_zero
+  }
+  if (read_bit()) {
+    return false; // show_existing_frame
+  }
+  return read_bit() == 0; // frame_type：0 为关键帧
+}
+} // namespace
+
+VpxRtpPacketizer::VpxRtpPacketizer(
+    Codec codec, std::shared_ptr<rtc::RtpPacketizationConfig> rtp_config,
+    uint16_t max_fragment_size)
+    : rtc::RtpPacketizer(std::move(rtp_config)), codec_(codec),
+      max_fragment_size_(max_fragment_size) {}
+
+std::vector<rtc::binary> VpxRtpPacketizer::fragment(rtc::binary data) {
+  std::vector<rtc::binary> fragments;
+  if (data.empty()) {
+    return fragments;
+  }
+
+  uint16_t picture_id = picture_id_;
+  picture_id_ = (picture_id_ + 1) & 0x7FFF;
+  uint8_t picture_id_high = kLongPictureId | (picture_id >> 8);
+  uint8_t picture_id_low = picture_id & 0xFF;
+  // VP9 非关键帧标记 P 位，接收端据此判断能否从该帧开始解码
+  bool inter_predicted = codec_ == Codec::VP9 && !vp9_is_keyframe(data);
+
+  size_t header_size = codec_ == Codec::VP9 ? 3 : 4;
+  size_t chunk_size = max_fragment_size_ > header_size
+                          ? max_fragment_size_ - header_size
+                          : 1;
+  for (size_t offset = 0; offset < data.size(); offset += chunk_size) {
+    size_t size = std::min(chunk_size, data.size() - offset);
+    bool first = offset == 0;
+    bool last = offset + size == data.size();
+
+    rtc::binary payload;
+    payload.reserve(header_size + size);
+    if (codec_ == Codec::VP9) {
+      uint8_t flags = kVp9PictureIdPresent;
+      if (inter_predicted) {
+        flags |= kVp9InterPredicted;
+      }
+      if (first) {
+        flags |= kVp9StartOfFrame;
+      }
+      if (last) {
+        flags |= kVp9EndOfFrame;
+      }
+      payload.push_back(std::byte(flags));
+    } else {
+      // 整帧作为一个分区（PID=0），只有第一个包标记 S
+      payload.push_back(
+          std::byte(kVp8Extended | (first ? kVp8StartOfPartition : 0)));
+      payload.push_back(std::byte(kVp8PictureIdPresent));
+    }
+    payload.push_back(std::byte(picture_id_high));
+    payload.push_back(std::byte(picture_id_low));
+    payload.insert(payload.end(), data.begin() + offset,
+                   data.begin() + offset + size);
+    fragments.push_back(std::move(payload));
+  }
+  return fragments;
+}
@@ -10,11 +10,16 @@
 
 #include "audio_player.h"
 #include "opus_encoder.h"
+#include "vpx_packetizer.h"
 #include "rtc/rtc.hpp"
 #include <algorithm>
 #include <random>
 #include <nlohmann/json.hpp>
 
+// 视频 RTP 包的最大负载；低延迟 slice 模式下编码器按该大小切分 slice，
+// 每个 slice 正好放进一个 RTP 包
+constexpr uint16_t kVideoRtpMaxFragmentSize = 1200;
+
 template <class T> weak_ptr<T> make_weak_ptr(shared_ptr<T> ptr) {
   return weak_ptr<T>(ptr);
 }
@@ -87,6 +92,15 @@ shared_ptr<rtc::PeerConnection> WebRTCPublisher::createPeerConnection(
       // 设置 H.265 参数（可选）
       media.addH265Codec(97, "level-id-id=93;profile-id=1");
       payload_type = 97;
+    } else if (video_codec == "vp8") {
+      media.addVP8Codec(98);
+      payload_type = 98;
+    } else if (video_codec == "vp9") {
+      media.addVP9Codec(99, "profile-id=0");
+      payload_type = 99;
+    } else if (video_codec == "av1") {
+      media.addAV1Codec(100);
+      payload_type = 100;
     } else {
       media.addH264Codec(96); // Add H.264 codec with payload type 96
       // 设置 H.264 参数（可选）
@@ -107,7 +121,7 @@ shared_ptr<rtc::PeerConnection> WebRTCPublisher::createPeerConnection(
     auto rtpConfig = std::make_shared<rtc::RtpPacketizationConfig>(
         video_ssrc, cname,
         payload_type,
-        rtc::H264RtpPacketizer::ClockRate); // H.265使用相同的时钟频率
+        rtc::H264RtpPacketizer::ClockRate); // 所有视频编码都使用 90kHz 时钟
 
     // 根据编码器类型创建相应的RTP打包器
     std::shared_ptr<rtc::MediaHandler> packetizer;
@@ -115,13 +129,26 @@ shared_ptr<rtc::PeerConnection> WebRTCPublisher::createPeerConnection(
       // 创建 H.265 RTP 打包器
       packetizer = std::make_shared<rtc::H265RtpPacketizer>(
           rtc::NalUnit::Separator::StartSequence, // 使用长起始序列
-          rtpConfig);
+          rtpConfig, kVideoRtpMaxFragmentSize);
       std::cout << "Created H.265 RTP packetizer" << std::endl;
+    } else if (video_codec == "vp8" || video_codec == "vp9") {
+      packetizer = std::make_shared<VpxRtpPacketizer>(
+          video_codec == "vp9" ? VpxRtpPacketizer::Codec::VP9
+                               : VpxRtpPacketizer::Codec::VP8,
+          rtpConfig, kVideoRtpMaxFragmentSize);
+      std::cout << "Created " << (video_codec == "vp9" ? "VP9" : "VP8")
+                << " RTP packetizer" << std::endl;
+    } else if (video_codec == "av1") {
+      // 编码器每次输出一个时间单元（低开销 OBU 格式）
+      packetizer = std::make_shared<rtc::AV1RtpPacketizer>(
+          rtc::AV1RtpPacketizer::Packetization::TemporalUnit, rtpConfig,
+          kVideoRtpMaxFragmentSize);
+      std::cout << "Created AV1 RTP packetizer" << std::endl;
     } else {
       // 创建 H.264 RTP 打包器
       packetizer = std::make_shared<rtc::H264RtpPacketizer>(
           rtc::NalUnit::Separator::StartSequence, // 使用长起始序列
-          rtpConfig);
+          rtpConfig, kVideoRtpMaxFragmentSize);
       std::cout << "Created H.264 RTP packetizer" << std::endl;
     }
 
@@ -133,6 +160,14 @@ shared_ptr<rtc::PeerConnection> WebRTCPublisher::createPeerConnection(
     auto nackResponder = std::make_shared<rtc::RtcpNackResponder>();
     packetizer->addToChain(nackResponder);
 
+    // 添加 RTCP PLI 处理器：接收端丢失参考帧或刚加入时请求关键帧
+    auto pliHandler = std::make_shared<rtc::PliHandler>([this]() {
+      if (video_capturer_) {
+        video_capturer_->request_keyframe();
+      }
+    });
+    packetizer->addToChain(pliHandler);
+
     // 设置轨道的媒体处理器
     video_track->setMediaHandler(packetizer);
 
@@ -324,12 +359,19 @@ shared_ptr<rtc::PeerConnection> WebRTCPublisher::createPeerConnection(
                 int fps = msg.value("fps", 30);
                 int bitrate = msg.value("bitrate", 3200000);
                 std::string format = msg.value("format", "yuyv422");
+                // 未指定时保持当前的旋转设置
+                int rotation =
+                    msg.value("rotation", video_capturer_->get_rotation());
+                bool mirror = msg.value("mirror", video_capturer_->get_mirror());
 
                 std::cout << "Video config: " << resolution << ", " << fps
-                          << "fps, " << bitrate << "bps, " << format << std::endl;
+                          << "fps, " << bitrate << "bps, " << format
+                          << ", rotation " << rotation
+                          << (mirror ? " mirrored" : "") << std::endl;
 
                 // 调用视频配置重置方法
-                video_capturer_->reconfigure(resolution, fps, bitrate, format);
+                video_capturer_->reconfigure(resolution, fps, bitrate, format,
+                                             rotation, mirror);
               }
             }
           }
@@ -396,6 +438,28 @@ WebRTCPublisher::WebRTCPublisher(const std::string &client_id, Cmdline params)
                                         queue_size, queue_size);
     // 设置视频编码器类型
     video_capturer_->set_video_codec(params.videoCodec());
+    video_capturer_->set_queue_stats_interval(params.queueStatsInterval());
+    video_capturer_->set_stage_budget_ms(PipelineStage::Decode,
+                                         params.decodeBudget());
+    video_capturer_->set_stage_budget_ms(PipelineStage::Encode,
+                                         params.encodeBudget());
+    video_capturer_->set_stage_budget_ms(PipelineStage::Send,
+                                         params.sendBudget());
+    video_capturer_->set_fused_pipeline(params.fusedPipeline());
+    video_capturer_->set_camera_passthrough(params.cameraPassthrough());
+    video_capturer_->set_output_resolution(params.outResolution());
+    video_capturer_->set_scale_threads(params.scaleThreads());
+    video_capturer_->set_rotation(params.rotation(), params.mirror());
+    video_capturer_->set_idle_grace_period(params.idleGrace());
+    video_capturer_->set_intra_refresh(params.intraRefresh(),
+                                       !params.noJoinIdr());
+    if (params.lowLatencySlices()) {
+      video_capturer_->set_max_slice_size(kVideoRtpMaxFragmentSize);
+    }
+    video_capturer_->set_codec_threads(params.decoderThreads(),
+                                       params.encoderThreads(),
+                                       params.frameThreads() &&
+                                           !params.lowLatencySlices());
   } else {
     video_capturer_ = nullptr;
   }
@@ -410,6 +474,14 @@ WebRTCPublisher::WebRTCPublisher(const std::string &client_id, Cmdline params)
     audio_capturer_ =
         new AudioCapturer(audio_params, params.debug(), queue_size,
             queue_size, queue_size);
+    audio_capturer_->set_queue_stats_interval(params.queueStatsInterval());
+    audio_capturer_->set_stage_budget_ms(PipelineStage::Decode,
+                                         params.decodeBudget());
+    audio_capturer_->set_stage_budget_ms(PipelineStage::Encode,
+                                         params.encodeBudget());
+    audio_capturer_->set_stage_budget_ms(PipelineStage::Send,
+                                         params.sendBudget());
+    audio_capturer_->set_fused_pipeline(params.fusedPipeline());
   } else {
     audio_capturer_ = nullptr;
   }
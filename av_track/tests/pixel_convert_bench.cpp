@@ -0,0 +1,95 @@
+// 快速像素转换的微基准：每种可用的实现与 sws_scale 在相同输入上的单帧耗时。
+// 用法：pixel_convert_bench [迭代次数]，默认 200
+#include "pixel_convert.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+
+namespace {
+
+const char *const kKernelNames[] = {"avx2", "sse2", "neon", "scalar"};
+
+struct Frame {
+  AVFrame *frame = av_frame_alloc();
+  Frame(AVPixelFormat format, int width, int height) {
+    frame->format = format;
+    frame->width = width;
+    frame->height = height;
+    av_frame_get_buffer(frame, 32);
+    // 固定内容即可，耗时与像素值无关
+    for (int p = 0; p < AV_NUM_DATA_POINTERS && frame->buf[p]; ++p) {
+      for (size_t i = 0; i < frame->buf[p]->size; ++i) {
+        frame->buf[p]->data[i] = static_cast<uint8_t>(i * 7);
+      }
+    }
+  }
+  ~Frame() { av_frame_free(&frame); }
+};
+
+template <typename Fn> double time_per_frame_us(int iterations, Fn fn) {
+  fn(); // 预热缓存
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    fn();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::micro>(elapsed).count() /
+         iterations;
+}
+
+void bench(AVPixelFormat format, int width, int height, bool half,
+           int iterations) {
+  int out_width = half ? width / 2 : width;
+  int out_height = half ? height / 2 : height;
+  Frame src(format, width, height);
+  Frame dst(AV_PIX_FMT_YUV420P, out_width, out_height);
+
+  std::printf("%-7s %4dx%-4d -> %4dx%-4d", format == AV_PIX_FMT_NV12 ? "nv12"
+                                                                     : "yuyv422",
+              width, height, out_width, out_height);
+  SwsContext *context =
+      sws_getContext(width, height, format, out_width, out_height,
+                     AV_PIX_FMT_YUV420P, SWS_BILINEAR, nullptr, nullptr,
+                     nullptr);
+  if (context) {
+    double us = time_per_frame_us(iterations, [&] {
+      sws_scale(context, src.frame->data, src.frame->linesize, 0, height,
+                dst.frame->data, dst.frame->linesize);
+    });
+    std::printf("  sws %8.1fus", us);
+    sws_freeContext(context);
+  }
+  for (const char *name : kKernelNames) {
+    if (!set_fast_convert_kernel(name)) {
+      continue;
+    }
+    double us = time_per_frame_us(
+        iterations, [&] { fast_convert_frame(src.frame, dst.frame); });
+    std::printf("  %s %8.1fus", name, us);
+  }
+  std::printf("\n");
+  set_fast_convert_kernel(nullptr);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int iterations = argc > 1 ? std::atoi(argv[1]) : 200;
+  if (iterations <= 0) {
+    iterations = 200;
+  }
+  const int sizes[][2] = {{640, 480}, {1280, 720}, {1920, 1080}};
+  for (AVPixelFormat format : {AV_PIX_FMT_YUYV422, AV_PIX_FMT_NV12}) {
+    for (const auto &size : sizes) {
+      bench(format, size[0], size[1], false, iterations);
+      bench(format, size[0], size[1], true, iterations);
+    }
+  }
+  return 0;
+}
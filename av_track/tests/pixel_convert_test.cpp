@@ -0,0 +1,213 @@
+// 快速像素转换与 sws_scale 的一致性测试：每种可用的实现（avx2、sse2、neon、scalar）
+// 分别与 sws_scale 输出比较，并与标量实现比较，覆盖同尺寸和缩小一半、
+// 不是向量宽度整数倍的宽度，以及带填充的行步长。
+// 用法：pixel_convert_test，全部通过时返回 0
+#include "pixel_convert.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+
+namespace {
+
+const char *const kKernelNames[] = {"avx2", "sse2", "neon", "scalar"};
+
+// 带独立缓冲区的帧，行步长 = 有效宽度 + padding，用于覆盖非对齐步长
+struct Image {
+  std::vector<uint8_t> planes[3];
+  AVFrame *frame = nullptr;
+
+  Image(AVPixelFormat format, int width, int height, int padding) {
+    frame = av_frame_alloc();
+    frame->format = format;
+    frame->width = width;
+    frame->height = height;
+    int widths[3] = {width, 0, 0};
+    int heights[3] = {height, 0, 0};
+    if (format == AV_PIX_FMT_YUYV422) {
+      widths[0] = width * 2;
+    } else if (format == AV_PIX_FMT_NV12) {
+      widths[1] = (width + 1) / 2 * 2;
+      heights[1] = (height + 1) / 2;
+    } else {
+      widths[1] = widths[2] = (width + 1) / 2;
+      heights[1] = heights[2] = (height + 1) / 2;
+    }
+    for (int p = 0; p < 3; ++p) {
+      if (widths[p] == 0) {
+        continue;
+      }
+      frame->linesize[p] = widths[p] + padding;
+      planes[p].assign(static_cast<size_t>(frame->linesize[p]) * heights[p],
+                       0);
+      frame->data[p] = planes[p].data();
+    }
+  }
+  ~Image() { av_frame_free(&frame); }
+  Image(const Image &) = delete;
+  Image &operator=(const Image &) = delete;
+};
+
+// noise 为 true 时填充随机数（用于实现之间比较），否则填充平滑渐变
+// （与 sws_scale 比较，滤波器和色度采样位置的差异在平滑图像上只有舍入误差）
+void fill(Image &image, bool noise, unsigned seed) {
+  std::mt19937 rng(seed);
+  for (int p = 0; p < 3; ++p) {
+    std::vector<uint8_t> &plane = image.planes[p];
+    if (plane.empty()) {
+      continue;
+    }
+    int stride = image.frame->linesize[p];
+    for (size_t i = 0; i < plane.size(); ++i) {
+      int x = static_cast<int>(i % stride);
+      int y = static_cast<int>(i / stride);
+      plane[i] = noise ? static_cast<uint8_t>(rng())
+                       : static_cast<uint8_t>(64 + (x + y + p * 16) / 4 % 128);
+    }
+  }
+}
+
+// 返回两个 YUV420P 帧有效区域内的最大差值
+int max_difference(const AVFrame *a, const AVFrame *b) {
+  int diff = 0;
+  for (int p = 0; p < 3; ++p) {
+    int width = p == 0 ? a->width : a->width / 2;
+    int height = p == 0 ? a->height : a->height / 2;
+    for (int y = 0; y < height; ++y) {
+      const uint8_t *row_a = a->data[p] + y * a->linesize[p];
+      const uint8_t *row_b = b->data[p] + y * b->linesize[p];
+      for (int x = 0; x < width; ++x) {
+        diff = std::max(diff, std::abs(row_a[x] - row_b[x]));
+      }
+    }
+  }
+  return diff;
+}
+
+bool sws_convert(const AVFrame *src, AVFrame *dst) {
+  SwsContext *context = sws_getContext(
+      src->width, src->height, static_cast<AVPixelFormat>(src->format),
+      dst->width, dst->height, AV_PIX_FMT_YUV420P, SWS_BILINEAR, nullptr,
+      nullptr, nullptr);
+  if (!context) {
+    return false;
+  }
+  sws_scale(context, src->data, src->linesize, 0, src->height, dst->data,
+            dst->linesize);
+  sws_freeContext(context);
+  return true;
+}
+
+struct Case {
+  AVPixelFormat format;
+  int width;  // 输出宽度
+  int height; // 输出高度
+  bool half;  // 源为输出的两倍尺寸
+  int padding;
+};
+
+int failures = 0;
+
+void check(bool ok, const char *kernel, const Case &c, const char *what,
+           int diff) {
+  if (!ok) {
+    ++failures;
+    std::printf("FAIL %-6s %s %dx%d%s padding=%d: %s (max diff %d)\n", kernel,
+                c.format == AV_PIX_FMT_NV12 ? "nv12" : "yuyv422", c.width,
+                c.height, c.half ? " half" : "", c.padding, what, diff);
+  }
+}
+
+void run_case(const Case &c) {
+  int src_width = c.half ? c.width * 2 : c.width;
+  int src_height = c.half ? c.height * 2 : c.height;
+
+  // 与 sws_scale 比较：同尺寸只差色度平均的舍入，缩小一半时滤波器不同
+  const int sws_tolerance = c.half ? 2 : 1;
+  Image smooth(c.format, src_width, src_height, c.padding);
+  fill(smooth, false, 0);
+  Image reference(AV_PIX_FMT_YUV420P, c.width, c.height, c.padding);
+  if (!sws_convert(smooth.frame, reference.frame)) {
+    check(false, "sws", c, "sws_getContext failed", 0);
+    return;
+  }
+
+  // 实现之间比较：SIMD 与标量的差异只来自两次舍入，最多为 1
+  Image noise(c.format, src_width, src_height, c.padding);
+  fill(noise, true, c.width * 31 + c.height);
+  set_fast_convert_kernel("scalar");
+  Image scalar(AV_PIX_FMT_YUV420P, c.width, c.height, c.padding + 3);
+  check(fast_convert_frame(noise.frame, scalar.frame), "scalar", c,
+        "conversion rejected", 0);
+
+  for (const char *name : kKernelNames) {
+    if (!set_fast_convert_kernel(name)) {
+      continue;
+    }
+    Image out(AV_PIX_FMT_YUV420P, c.width, c.height, c.padding + 1);
+    bool converted = fast_convert_frame(smooth.frame, out.frame);
+    check(converted, name, c, "conversion rejected", 0);
+    if (converted) {
+      int diff = max_difference(out.frame, reference.frame);
+      check(diff <= sws_tolerance, name, c, "differs from sws_scale", diff);
+    }
+
+    Image out_noise(AV_PIX_FMT_YUV420P, c.width, c.height, c.padding);
+    if (fast_convert_frame(noise.frame, out_noise.frame)) {
+      int diff = max_difference(out_noise.frame, scalar.frame);
+      check(diff <= (c.half ? 1 : 0), name, c, "differs from scalar", diff);
+    }
+  }
+  set_fast_convert_kernel(nullptr);
+}
+
+void check_rejected(AVPixelFormat format, int src_width, int src_height,
+                    int dst_width, int dst_height) {
+  if (fast_convert_supported(format, src_width, src_height,
+                             AV_PIX_FMT_YUV420P, dst_width, dst_height)) {
+    ++failures;
+    std::printf("FAIL %dx%d -> %dx%d should fall back to sws_scale\n",
+                src_width, src_height, dst_width, dst_height);
+  }
+}
+
+} // namespace
+
+int main() {
+  const AVPixelFormat formats[] = {AV_PIX_FMT_YUYV422, AV_PIX_FMT_NV12};
+  // 宽度覆盖 AVX2（32）、SSE2/NEON（16）的整数倍和各种余数
+  const int sizes[][2] = {{640, 480}, {1280, 720}, {642, 362}, {38, 22},
+                          {34, 2},    {2, 2},      {66, 18},   {98, 6}};
+  const int paddings[] = {0, 7, 64};
+
+  for (AVPixelFormat format : formats) {
+    for (const auto &size : sizes) {
+      for (int padding : paddings) {
+        run_case({format, size[0], size[1], false, padding});
+        run_case({format, size[0], size[1], true, padding});
+      }
+    }
+    // 奇数尺寸和非整数倍缩放不走快速路径，由 sws_scale 处理
+    check_rejected(format, 641, 480, 641, 480);
+    check_rejected(format, 640, 481, 640, 481);
+    check_rejected(format, 1282, 722, 641, 361);
+    check_rejected(format, 1280, 720, 960, 540);
+  }
+
+  std::printf("pixel_convert_test: %s, kernels:", failures ? "FAILED" : "OK");
+  for (const char *name : kKernelNames) {
+    if (set_fast_convert_kernel(name)) {
+      std::printf(" %s", name);
+    }
+  }
+  std::printf("\n");
+  set_fast_convert_kernel(nullptr);
+  return failures ? 1 : 0;
+}